@@ -0,0 +1,61 @@
+#include "Allocator.h"
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <new>
+
+namespace IO {
+
+	Allocator::~Allocator() {}
+
+	void* Allocator::Reallocate(void* address, size_t old_bytes, size_t new_bytes) {
+
+		void* new_address = Allocate(new_bytes);
+
+		if (address) {
+			memcpy(new_address, address, (std::min)(old_bytes, new_bytes));
+			Deallocate(address, old_bytes);
+		}
+
+		return new_address;
+
+	}
+	bool Allocator::ShouldTrim(size_t old_bytes, size_t new_bytes) const {
+
+		return false;
+
+	}
+
+	Allocator& Allocator::Default() {
+
+		static HeapAllocator allocator;
+		return allocator;
+
+	}
+
+	void* HeapAllocator::Allocate(size_t bytes) {
+
+		// Always allocate at least one byte, so that a successful allocation is never null.
+		void* address = malloc(bytes > 0 ? bytes : 1);
+		if (!address)
+			throw std::bad_alloc();
+
+		return address;
+
+	}
+	void* HeapAllocator::Reallocate(void* address, size_t old_bytes, size_t new_bytes) {
+
+		void* new_address = realloc(address, new_bytes > 0 ? new_bytes : 1);
+		if (!new_address)
+			throw std::bad_alloc();
+
+		return new_address;
+
+	}
+	void HeapAllocator::Deallocate(void* address, size_t bytes) {
+
+		free(address);
+
+	}
+
+}
\ No newline at end of file
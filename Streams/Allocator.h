@@ -0,0 +1,42 @@
+#pragma once
+#include "IO.h"
+#include <cstddef>
+
+namespace IO {
+
+	// Provides an interface for allocating the memory used by streams and buffers, so that it can come from somewhere other than the general-purpose heap.
+	class Allocator {
+
+	public:
+		virtual ~Allocator();
+
+		// Allocates a block of at least "bytes" bytes, aligned for any fundamental type. The contents of the block are undefined.
+		virtual void* Allocate(size_t bytes) = 0;
+		// Resizes a block allocated by this allocator, moving it if necessary, and returns its new address. The contents are preserved up to the lesser of the two sizes.
+		// By default, allocates a new block, copies the contents, and deallocates the old block.
+		virtual void* Reallocate(void* address, size_t old_bytes, size_t new_bytes);
+		// Deallocates a block allocated by this allocator. "bytes" must be the size the block was allocated (or last reallocated) with.
+		virtual void Deallocate(void* address, size_t bytes) = 0;
+		// Returns true if a block of "old_bytes" bytes that is only partly used should be reallocated down to "new_bytes" bytes, because doing so returns memory to the system.
+		// By default returns false, so that a block keeps its capacity for reuse.
+		virtual bool ShouldTrim(size_t old_bytes, size_t new_bytes) const;
+
+		// Returns the process-wide allocator that uses malloc, realloc and free.
+		static Allocator& Default();
+
+	};
+
+	// Provides an allocator that uses malloc, realloc and free.
+	class HeapAllocator : public Allocator {
+
+	public:
+		// Allocates a block with malloc.
+		virtual void* Allocate(size_t bytes) override;
+		// Resizes a block with realloc.
+		virtual void* Reallocate(void* address, size_t old_bytes, size_t new_bytes) override;
+		// Frees a block with free.
+		virtual void Deallocate(void* address, size_t bytes) override;
+
+	};
+
+}
\ No newline at end of file
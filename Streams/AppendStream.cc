@@ -0,0 +1,201 @@
+#include "AppendStream.h"
+#include "Exception.h"
+
+namespace IO {
+
+	namespace {
+
+		// The file is always written at explicit offsets, so appending is emulated with a seekable descriptor.
+		FileMode AppendMode(FileMode mode) {
+
+			return mode == FileMode::Append ? FileMode::OpenOrCreate : mode;
+
+		}
+
+	}
+
+	AppendStream::AppendStream(const char* path) : AppendStream(path, FileMode::OpenOrCreate) {}
+	AppendStream::AppendStream(const char* path, FileMode mode) :
+		_file(path, AppendMode(mode), FileAccess::Write) {
+
+		// Initialize member variables. Appending begins after the existing contents of the file.
+		_tail = _file.Length();
+		_watermark = _tail;
+
+	}
+	AppendStream::~AppendStream() {
+
+		Close();
+
+	}
+
+	size_t AppendStream::Length() {
+
+		return _tail;
+
+	}
+	size_t AppendStream::Position() const {
+
+		return _tail;
+
+	}
+	size_t AppendStream::Watermark() const {
+
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		return _watermark;
+
+	}
+	size_t AppendStream::Append(const void* buffer, size_t length) {
+
+		ConstSpan span = { (const Byte*)buffer, length };
+
+		return Append(&span, 1);
+
+	}
+	size_t AppendStream::Append(const ConstSpan* spans, size_t count) {
+
+		// Throw an exception of the stream is not writeable.
+		if (!CanWrite())
+			throw NotSupportedException();
+
+		size_t length = 0;
+		for (size_t i = 0; i < count; ++i)
+			length += spans[i].length;
+
+		// Reserve a range at the end of the file. This is the only point at which writers synchronize with each other.
+		size_t offset = _tail.fetch_add(length);
+		if (length == 0)
+			return offset;
+
+		// Write the record into the reserved range, and record its completion even if the write fails so that Flush does not wait forever.
+		try {
+			if (_file.CanAccessConcurrently())
+				_file.WriteVAt(offset, spans, count);
+			else {
+				std::lock_guard<std::mutex> lock(_write_mutex);
+				_file.WriteVAt(offset, spans, count);
+			}
+		}
+		catch (...) {
+			Complete(offset, length, std::current_exception());
+			throw;
+		}
+
+		Complete(offset, length, nullptr);
+
+		return offset;
+
+	}
+	void AppendStream::Flush() {
+
+		Flush(_tail);
+
+	}
+	void AppendStream::Flush(size_t watermark) {
+
+		std::unique_lock<std::mutex> lock(_mutex);
+
+		_advanced.wait(lock, [this, watermark] { return _watermark >= watermark; });
+
+		// If any write failed, the file has a gap in it.
+		if (_error)
+			std::rethrow_exception(_error);
+
+	}
+	void AppendStream::Sync(SyncMode mode) {
+
+		Flush();
+		_file.Sync(mode);
+
+	}
+	void AppendStream::SetLength(size_t length) {
+
+		throw NotSupportedException();
+
+	}
+	bool AppendStream::ReadByte(Byte& byte) {
+
+		throw NotSupportedException();
+
+	}
+	void AppendStream::WriteByte(Byte byte) {
+
+		Append(&byte, 1);
+
+	}
+	void AppendStream::Write(const void* buffer, size_t offset, size_t length) {
+
+		Append((const Byte*)buffer + offset * sizeof(Byte), length);
+
+	}
+	void AppendStream::WriteV(const ConstSpan* spans, size_t count) {
+
+		Append(spans, count);
+
+	}
+	void AppendStream::Close() {
+
+		if (!_file.CanWrite())
+			return;
+
+		// Wait for writes still in progress, without throwing from the destructor if one of them failed.
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			size_t tail = _tail;
+			_advanced.wait(lock, [this, tail] { return _watermark >= tail; });
+		}
+
+		_file.Close();
+
+	}
+	size_t AppendStream::Seek(long long offset, SeekOrigin origin) {
+
+		throw NotSupportedException();
+
+	}
+	size_t AppendStream::Seek(long long position) {
+
+		throw NotSupportedException();
+
+	}
+	bool AppendStream::CanRead() const {
+
+		return false;
+
+	}
+	bool AppendStream::CanSeek() const {
+
+		return false;
+
+	}
+	bool AppendStream::CanWrite() const {
+
+		return _file.CanWrite();
+
+	}
+
+	// Protected methods
+
+	void AppendStream::Complete(size_t offset, size_t length, std::exception_ptr error) {
+
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		if (error && !_error)
+			_error = error;
+
+		// Ranges can complete in any order. Hold on to the ones above a gap until the gap is filled.
+		if (offset != _watermark) {
+			_completed[offset] = length;
+			return;
+		}
+
+		_watermark += length;
+		for (auto it = _completed.begin(); it != _completed.end() && it->first == _watermark; it = _completed.erase(it))
+			_watermark += it->second;
+
+		_advanced.notify_all();
+
+	}
+
+}
\ No newline at end of file
@@ -0,0 +1,88 @@
+#pragma once
+#include "IStream.h"
+#include "FileStream.h"
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <map>
+#include <mutex>
+
+namespace IO {
+
+	// Provides a write-only Stream that appends to a file from many threads at once.
+	// Each write atomically reserves a range at the end of the file by advancing the tail, and then writes its bytes at that offset in parallel with other writers.
+	// Writes therefore never interleave, but may complete out of order; Flush waits for every reservation below a watermark to complete.
+	class AppendStream : public IStream {
+
+	public:
+		// Initializes a new instance of the AppendStream class that appends to the file at the given path, creating it if it does not exist.
+		AppendStream(const char* path);
+		// Initializes a new instance of the AppendStream class with the specified path and creation mode. FileMode::Append is treated as FileMode::OpenOrCreate.
+		AppendStream(const char* path, FileMode mode);
+		// Waits for all writes to complete, and releases all resources used by the Stream.
+		virtual ~AppendStream();
+
+		// Gets the length in bytes of the stream, including ranges that have been reserved but not yet written.
+		virtual size_t Length() override;
+		// Gets the current position of this stream, which is always the end of the stream.
+		virtual size_t Position() const override;
+		// Gets the offset below which every reserved range has been written.
+		size_t Watermark() const;
+		// Appends a block of bytes to the file, and returns the offset it was written at. Safe to call from multiple threads.
+		size_t Append(const void* buffer, size_t length);
+		// Appends the contents of each of the given spans to the file as a single contiguous record, and returns the offset it was written at.
+		size_t Append(const ConstSpan* spans, size_t count);
+		// Waits until every range reserved before the call has been written.
+		virtual void Flush() override;
+		// Waits until every range reserved below the given offset has been written.
+		void Flush(size_t watermark);
+		// Waits until every range reserved before the call has been written, and then syncs the file.
+		void Sync(SyncMode mode);
+		// Throws NotSupportedException, since the stream only grows by appending.
+		virtual void SetLength(size_t length) override;
+		// Throws NotSupportedException, since the stream is write-only.
+		virtual bool ReadByte(Byte& byte) override;
+		// Appends a byte to the file.
+		virtual void WriteByte(Byte byte) override;
+		// Appends a block of bytes to the file.
+		virtual void Write(const void* buffer, size_t offset, size_t length) override;
+		// Appends the contents of each of the given spans to the file as a single contiguous record.
+		virtual void WriteV(const ConstSpan* spans, size_t count) override;
+		// Waits for all writes to complete, and closes the file.
+		virtual void Close() override;
+		// Throws NotSupportedException, since the stream is not seekable.
+		virtual size_t Seek(long long offset, SeekOrigin origin) override;
+		// Throws NotSupportedException, since the stream is not seekable.
+		virtual size_t Seek(long long position) override;
+		// Gets a value indicating whether the current stream supports reading.
+		virtual bool CanRead() const override;
+		// Gets a value indicating whether the current stream supports seeking.
+		virtual bool CanSeek() const override;
+		// Gets a value indicating whether the current stream supports writing.
+		virtual bool CanWrite() const override;
+
+	protected:
+		// Records that the range beginning at "offset" has been written (or failed to be), and advances the watermark over any completed ranges.
+		void Complete(size_t offset, size_t length, std::exception_ptr error);
+
+	private:
+		// The underlying file.
+		FileStream _file;
+		// The end of the last reserved range.
+		std::atomic<size_t> _tail;
+		// Serializes writes on platforms where positional writes to the file can't be made concurrently.
+		std::mutex _write_mutex;
+		// Protects the members below. Only held for bookkeeping, never while writing.
+		mutable std::mutex _mutex;
+		// Signalled when the watermark advances.
+		std::condition_variable _advanced;
+		// The offset below which every reserved range has been written.
+		size_t _watermark;
+		// Ranges above the watermark that have been written, keyed by offset.
+		std::map<size_t, size_t> _completed;
+		// The exception thrown by the first failed write.
+		std::exception_ptr _error;
+
+	};
+
+}
\ No newline at end of file
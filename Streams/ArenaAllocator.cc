@@ -0,0 +1,161 @@
+#include "ArenaAllocator.h"
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <new>
+
+namespace IO {
+
+	namespace {
+
+		// The size of heap blocks used by default.
+		const size_t DEFAULT_BLOCK_SIZE = 64 * 1024;
+		// The size that blocks stop doubling at, unless the default block size is larger.
+		const size_t MAX_BLOCK_GROWTH = 16 * 1024 * 1024;
+		// The alignment of every allocation.
+		const size_t ARENA_ALIGNMENT = alignof(std::max_align_t);
+
+	}
+
+	// The header at the start of each block allocated from the heap.
+	struct ArenaAllocator::Block {
+		// The previously allocated block.
+		Block* previous;
+		// The size of the block, including the header.
+		size_t size;
+	};
+
+	ArenaAllocator::ArenaAllocator() : ArenaAllocator(DEFAULT_BLOCK_SIZE) {}
+	ArenaAllocator::ArenaAllocator(size_t block_size) : ArenaAllocator(nullptr, 0) {
+
+		_block_size = block_size;
+
+	}
+	ArenaAllocator::ArenaAllocator(void* buffer, size_t size) {
+
+		// Initialize member variables.
+		_block_size = DEFAULT_BLOCK_SIZE;
+		_initial_buffer = (Byte*)buffer;
+		_initial_size = size;
+		_blocks = nullptr;
+		_current = _initial_buffer;
+		_end = _initial_buffer + size;
+		_last = nullptr;
+		_bytes_allocated = 0;
+
+	}
+	ArenaAllocator::~ArenaAllocator() {
+
+		while (_blocks) {
+			Block* previous = _blocks->previous;
+			free(_blocks);
+			_blocks = previous;
+		}
+
+	}
+
+	void* ArenaAllocator::Allocate(size_t bytes) {
+
+		// Round the current pointer up so that every allocation is suitably aligned.
+		Byte* address = (Byte*)AlignUp((size_t)(uintptr_t)_current, ARENA_ALIGNMENT);
+
+		// Zero-byte requests still take up space, so that every allocation has a distinct address.
+		size_t reserved = (std::max)(bytes, (size_t)1);
+
+		if (!_current || address > _end || (size_t)(_end - address) < reserved) {
+			AddBlock(reserved);
+			address = _current;
+		}
+
+		_current = address + reserved;
+		_last = address;
+		_bytes_allocated += bytes;
+
+		return address;
+
+	}
+	void* ArenaAllocator::Reallocate(void* address, size_t old_bytes, size_t new_bytes) {
+
+		// The most recent allocation can be resized in place, as long as it still fits in the current block.
+		if (address && address == _last && (size_t)(_end - _last) >= new_bytes) {
+			_current = _last + (std::max)(new_bytes, (size_t)1);
+			_bytes_allocated = _bytes_allocated - old_bytes + new_bytes;
+			return address;
+		}
+
+		return Allocator::Reallocate(address, old_bytes, new_bytes);
+
+	}
+	void ArenaAllocator::Deallocate(void* address, size_t bytes) {
+
+		// Only the most recent allocation can be given back. Anything else is freed by Release.
+		if (address && address == _last) {
+			_current = _last;
+			_last = nullptr;
+			_bytes_allocated -= bytes;
+		}
+
+	}
+	void ArenaAllocator::Release() {
+
+		// Keep the largest heap block, so that the next request can usually be served without touching the heap.
+		Block* largest = nullptr;
+		while (_blocks) {
+			Block* previous = _blocks->previous;
+			if (!largest || _blocks->size > largest->size) {
+				if (largest)
+					free(largest);
+				largest = _blocks;
+			}
+			else
+				free(_blocks);
+			_blocks = previous;
+		}
+
+		// Start from the initial buffer if there is one, and otherwise from the kept block.
+		if (_initial_buffer || !largest) {
+			if (largest)
+				free(largest);
+			_current = _initial_buffer;
+			_end = _initial_buffer + _initial_size;
+		}
+		else {
+			largest->previous = nullptr;
+			_blocks = largest;
+			_current = (Byte*)largest + AlignUp(sizeof(Block), ARENA_ALIGNMENT);
+			_end = (Byte*)largest + largest->size;
+		}
+
+		_last = nullptr;
+		_bytes_allocated = 0;
+
+	}
+	size_t ArenaAllocator::BytesAllocated() const {
+
+		return _bytes_allocated;
+
+	}
+
+	// Private methods
+
+	void ArenaAllocator::AddBlock(size_t bytes) {
+
+		// Blocks grow with the arena, so that large requests don't need many small blocks.
+		size_t header_size = AlignUp(sizeof(Block), ARENA_ALIGNMENT);
+		size_t size = _blocks ? (std::min)(_blocks->size * 2, MAX_BLOCK_GROWTH) : 0;
+		size = (std::max)(size, _block_size);
+		size = (std::max)(size, header_size + bytes);
+
+		Block* block = (Block*)malloc(size);
+		if (!block)
+			throw std::bad_alloc();
+
+		block->previous = _blocks;
+		block->size = size;
+		_blocks = block;
+		_current = (Byte*)block + header_size;
+		_end = (Byte*)block + size;
+
+	}
+
+}
\ No newline at end of file
@@ -0,0 +1,58 @@
+#pragma once
+#include "Allocator.h"
+
+namespace IO {
+
+	// Provides a monotonic allocator that hands out memory from large blocks by advancing a pointer, and frees it all at once.
+	// Deallocating does nothing (except for the most recent allocation, which is rolled back), so the arena suits request-scoped work whose memory can be released together at the end.
+	// Not safe to use from multiple threads at once.
+	class ArenaAllocator : public Allocator {
+
+	public:
+		// Initializes a new instance of the ArenaAllocator class with the default block size.
+		ArenaAllocator();
+		// Initializes a new instance of the ArenaAllocator class that allocates blocks of at least "block_size" bytes from the heap.
+		ArenaAllocator(size_t block_size);
+		// Initializes a new instance of the ArenaAllocator class that allocates from the given buffer first (for example, one on the stack), and from the heap once it is full.
+		ArenaAllocator(void* buffer, size_t size);
+		ArenaAllocator(const ArenaAllocator& other) = delete;
+		// Frees all memory allocated from the heap.
+		virtual ~ArenaAllocator();
+
+		// Allocates a block from the current arena block, starting a new one if it does not fit.
+		virtual void* Allocate(size_t bytes) override;
+		// Grows or shrinks the most recent allocation in place if possible. Otherwise, allocates a new block and copies the contents.
+		virtual void* Reallocate(void* address, size_t old_bytes, size_t new_bytes) override;
+		// Rolls back the most recent allocation. Other blocks are only freed by Release.
+		virtual void Deallocate(void* address, size_t bytes) override;
+		// Frees every allocation at once. Blocks allocated from the heap are returned to it, except for the largest, which is kept for reuse.
+		void Release();
+		// Gets the number of bytes handed out since the arena was created or last released.
+		size_t BytesAllocated() const;
+
+		ArenaAllocator& operator=(const ArenaAllocator& other) = delete;
+
+	private:
+		struct Block;
+
+		// Starts a new heap block large enough to hold "bytes" bytes.
+		void AddBlock(size_t bytes);
+
+		// The minimum size of blocks allocated from the heap.
+		size_t _block_size;
+		// The buffer given to the constructor, if any.
+		Byte* _initial_buffer;
+		size_t _initial_size;
+		// The most recently allocated heap block, which links to the ones before it.
+		Block* _blocks;
+		// The range of the current block that is free.
+		Byte* _current;
+		Byte* _end;
+		// The address of the most recent allocation.
+		Byte* _last;
+		// The number of bytes handed out.
+		size_t _bytes_allocated;
+
+	};
+
+}
\ No newline at end of file
@@ -0,0 +1,422 @@
+#include "AsyncFileStream.h"
+#include "Exception.h"
+#ifdef __linux__
+#include <cerrno>
+#include <cstring>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace IO {
+
+	namespace {
+
+		// glibc does not provide wrappers for the io_uring system calls.
+
+		int IoUringSetup(unsigned int entries, io_uring_params* params) {
+
+			return (int)syscall(__NR_io_uring_setup, entries, params);
+
+		}
+		int IoUringEnter(int fd, unsigned int to_submit, unsigned int min_complete, unsigned int flags) {
+
+			return (int)syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0);
+
+		}
+		int IoUringRegister(int fd, unsigned int opcode, const void* arg, unsigned int nr_args) {
+
+			return (int)syscall(__NR_io_uring_register, fd, opcode, arg, nr_args);
+
+		}
+
+		// The rings are shared with the kernel, so indices must be read and written with acquire/release semantics.
+
+		unsigned int LoadAcquire(const unsigned int* p) {
+
+			return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+
+		}
+		void StoreRelease(unsigned int* p, unsigned int value) {
+
+			__atomic_store_n(p, value, __ATOMIC_RELEASE);
+
+		}
+
+		[[noreturn]] void ThrowError(int error) {
+
+			throw IOException(std::strerror(error));
+
+		}
+
+	}
+
+	AsyncFileStream::AsyncFileStream(const char* path, FileMode mode) : AsyncFileStream(path, mode, FileAccess::ReadWrite) {}
+	AsyncFileStream::AsyncFileStream(const char* path, FileMode mode, FileAccess access) : AsyncFileStream(path, mode, access, 64) {}
+	AsyncFileStream::AsyncFileStream(const char* path, FileMode mode, FileAccess access, unsigned int queue_depth) :
+		_file(path, mode, access) {
+
+		// Initialize member variables.
+		_ring_fd = -1;
+		_sq_ring = nullptr;
+		_cq_ring = nullptr;
+		_sqes = nullptr;
+		_queued = 0;
+		_in_flight = 0;
+
+		// Create the ring. If this fails, make sure the file is closed before the exception leaves the constructor.
+		try {
+			InitRing(queue_depth);
+		}
+		catch (...) {
+			Close();
+			throw;
+		}
+
+	}
+	AsyncFileStream::~AsyncFileStream() {
+
+		// Waiting for requests in flight can fail, and a destructor must not throw.
+		try {
+			Close();
+		}
+		catch (...) {}
+
+	}
+
+	size_t AsyncFileStream::Length() {
+
+		// Asynchronous writes can extend the file without the stream seeing them, so always query the file.
+		struct stat buf;
+		if (fstat(_file.Handle(), &buf) < 0)
+			ThrowError(errno);
+
+		return (size_t)buf.st_size;
+
+	}
+	void AsyncFileStream::SetLength(size_t length) {
+
+		_file.SetLength(length);
+
+	}
+	size_t AsyncFileStream::Queued() const {
+
+		return _queued;
+
+	}
+	size_t AsyncFileStream::InFlight() const {
+
+		return _in_flight;
+
+	}
+
+	bool AsyncFileStream::QueueRead(void* buffer, size_t length, size_t position, uint64_t user_data) {
+
+		if (!_file.CanRead())
+			throw NotSupportedException();
+
+		io_uring_sqe* sqe = (io_uring_sqe*)NextEntry(IORING_OP_READ, length, position, user_data);
+		if (!sqe)
+			return false;
+
+		sqe->addr = (uint64_t)(uintptr_t)buffer;
+
+		return true;
+
+	}
+	bool AsyncFileStream::QueueWrite(const void* buffer, size_t length, size_t position, uint64_t user_data) {
+
+		if (!_file.CanWrite())
+			throw NotSupportedException();
+
+		io_uring_sqe* sqe = (io_uring_sqe*)NextEntry(IORING_OP_WRITE, length, position, user_data);
+		if (!sqe)
+			return false;
+
+		sqe->addr = (uint64_t)(uintptr_t)buffer;
+
+		return true;
+
+	}
+	bool AsyncFileStream::QueueReadFixed(unsigned int buffer_index, size_t offset, size_t length, size_t position, uint64_t user_data) {
+
+		if (!_file.CanRead())
+			throw NotSupportedException();
+
+		// The range must lie within the registered buffer.
+		if (buffer_index >= _buffers.size() || offset + length > _buffers[buffer_index].length)
+			throw ArgumentException();
+
+		io_uring_sqe* sqe = (io_uring_sqe*)NextEntry(IORING_OP_READ_FIXED, length, position, user_data);
+		if (!sqe)
+			return false;
+
+		sqe->addr = (uint64_t)(uintptr_t)((Byte*)_buffers[buffer_index].data + offset);
+		sqe->buf_index = (uint16_t)buffer_index;
+
+		return true;
+
+	}
+	bool AsyncFileStream::QueueWriteFixed(unsigned int buffer_index, size_t offset, size_t length, size_t position, uint64_t user_data) {
+
+		if (!_file.CanWrite())
+			throw NotSupportedException();
+
+		// The range must lie within the registered buffer.
+		if (buffer_index >= _buffers.size() || offset + length > _buffers[buffer_index].length)
+			throw ArgumentException();
+
+		io_uring_sqe* sqe = (io_uring_sqe*)NextEntry(IORING_OP_WRITE_FIXED, length, position, user_data);
+		if (!sqe)
+			return false;
+
+		sqe->addr = (uint64_t)(uintptr_t)((Byte*)_buffers[buffer_index].data + offset);
+		sqe->buf_index = (uint16_t)buffer_index;
+
+		return true;
+
+	}
+	size_t AsyncFileStream::Submit() {
+
+		return Enter(0);
+
+	}
+	size_t AsyncFileStream::SubmitAndWait(size_t min_completions) {
+
+		return Enter(min_completions);
+
+	}
+	size_t AsyncFileStream::PollCompletions(AsyncCompletion* completions, size_t max_completions) {
+
+		if (_ring_fd < 0)
+			return 0;
+
+		// The head is only written by us, but the tail is written by the kernel.
+		unsigned int head = *_cq_head;
+		unsigned int tail = LoadAcquire(_cq_tail);
+		size_t count = 0;
+
+		while (head != tail && count < max_completions) {
+
+			const io_uring_cqe& cqe = ((const io_uring_cqe*)_cqes)[head & _cq_mask];
+			completions[count].user_data = cqe.user_data;
+			completions[count].result = cqe.res;
+
+			++head;
+			++count;
+
+		}
+
+		// Release the entries back to the kernel.
+		StoreRelease(_cq_head, head);
+		_in_flight -= count;
+
+		return count;
+
+	}
+	size_t AsyncFileStream::WaitCompletions(AsyncCompletion* completions, size_t max_completions, size_t min_completions) {
+
+		// We can't wait for more completions than there are requests, or than we have room to return.
+		if (min_completions > max_completions)
+			min_completions = max_completions;
+		if (min_completions > _queued + _in_flight)
+			min_completions = _queued + _in_flight;
+
+		size_t count = PollCompletions(completions, max_completions);
+
+		// Submit any queued requests, and wait in the kernel until enough completions are available.
+		while (count < min_completions) {
+			Enter(min_completions - count);
+			count += PollCompletions(completions + count, max_completions - count);
+		}
+
+		return count;
+
+	}
+
+	void AsyncFileStream::RegisterBuffers(const AsyncBuffer* buffers, size_t count) {
+
+		if (!_buffers.empty())
+			UnregisterBuffers();
+
+		std::vector<iovec> iovecs(count);
+		for (size_t i = 0; i < count; ++i) {
+			iovecs[i].iov_base = buffers[i].data;
+			iovecs[i].iov_len = buffers[i].length;
+		}
+
+		if (IoUringRegister(_ring_fd, IORING_REGISTER_BUFFERS, iovecs.data(), (unsigned int)count) < 0)
+			ThrowError(errno);
+
+		_buffers.assign(buffers, buffers + count);
+
+	}
+	void AsyncFileStream::UnregisterBuffers() {
+
+		if (_buffers.empty())
+			return;
+
+		if (IoUringRegister(_ring_fd, IORING_UNREGISTER_BUFFERS, nullptr, 0) < 0)
+			ThrowError(errno);
+
+		_buffers.clear();
+
+	}
+
+	void AsyncFileStream::Close() {
+
+		if (_ring_fd >= 0) {
+
+			// Wait for all outstanding requests, since the kernel may still be accessing their buffers.
+			AsyncCompletion completions[16];
+			while (_queued + _in_flight > 0)
+				WaitCompletions(completions, 16);
+
+			// Unmap the rings and close the ring.
+			if (_sqes)
+				munmap(_sqes, _sqes_size);
+			if (_cq_ring && _cq_ring != _sq_ring)
+				munmap(_cq_ring, _cq_ring_size);
+			if (_sq_ring)
+				munmap(_sq_ring, _sq_ring_size);
+			close(_ring_fd);
+
+		}
+
+		_ring_fd = -1;
+		_sq_ring = nullptr;
+		_cq_ring = nullptr;
+		_sqes = nullptr;
+		_buffers.clear();
+
+		// Close the file.
+		_file.Close();
+
+	}
+
+	// Protected methods
+
+	void* AsyncFileStream::NextEntry(uint8_t opcode, size_t length, size_t position, uint64_t user_data) {
+
+		if (_ring_fd < 0)
+			throw IOException("The stream is closed.");
+
+		// The length of a request is a 32-bit field, so larger requests would silently be truncated.
+		if (length > UINT32_MAX)
+			throw ArgumentException("length must be less than 4 GiB");
+
+		// Don't queue more requests than the completion queue can hold, or completions would be dropped.
+		if (_queued + _in_flight >= _cq_entries)
+			return nullptr;
+
+		// The tail is only written by us, but the head is written by the kernel as it consumes entries.
+		unsigned int tail = *_sq_tail;
+		if (tail - LoadAcquire(_sq_head) >= _sq_entries)
+			return nullptr;
+
+		unsigned int index = tail & _sq_mask;
+		io_uring_sqe* sqe = (io_uring_sqe*)_sqes + index;
+		memset(sqe, 0, sizeof(io_uring_sqe));
+
+		// All requests target the registered file at index 0.
+		sqe->opcode = opcode;
+		sqe->flags = IOSQE_FIXED_FILE;
+		sqe->fd = 0;
+		sqe->off = position;
+		sqe->len = (uint32_t)length;
+		sqe->user_data = user_data;
+
+		// Publish the entry to the kernel.
+		_sq_array[index] = index;
+		StoreRelease(_sq_tail, tail + 1);
+		++_queued;
+
+		return sqe;
+
+	}
+	size_t AsyncFileStream::Enter(size_t min_completions) {
+
+		unsigned int flags = min_completions > 0 ? IORING_ENTER_GETEVENTS : 0;
+
+		int result;
+		while ((result = IoUringEnter(_ring_fd, (unsigned int)_queued, (unsigned int)min_completions, flags)) < 0)
+			if (errno != EINTR)
+				ThrowError(errno);
+
+		_queued -= (size_t)result;
+		_in_flight += (size_t)result;
+
+		return (size_t)result;
+
+	}
+
+	// Private methods
+
+	void AsyncFileStream::InitRing(unsigned int queue_depth) {
+
+		io_uring_params params;
+		memset(&params, 0, sizeof(params));
+
+		_ring_fd = IoUringSetup(queue_depth, &params);
+		if (_ring_fd < 0)
+			ThrowError(errno);
+
+		// Map the submission and completion queue rings. Newer kernels allow both to be mapped with a single call.
+		_sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+		_cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+		if (params.features & IORING_FEAT_SINGLE_MMAP) {
+			if (_cq_ring_size > _sq_ring_size)
+				_sq_ring_size = _cq_ring_size;
+			_cq_ring_size = _sq_ring_size;
+		}
+
+		_sq_ring = mmap(nullptr, _sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _ring_fd, IORING_OFF_SQ_RING);
+		if (_sq_ring == MAP_FAILED) {
+			_sq_ring = nullptr;
+			ThrowError(errno);
+		}
+
+		if (params.features & IORING_FEAT_SINGLE_MMAP)
+			_cq_ring = _sq_ring;
+		else {
+			_cq_ring = mmap(nullptr, _cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _ring_fd, IORING_OFF_CQ_RING);
+			if (_cq_ring == MAP_FAILED) {
+				_cq_ring = nullptr;
+				ThrowError(errno);
+			}
+		}
+
+		_sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+		_sqes = mmap(nullptr, _sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _ring_fd, IORING_OFF_SQES);
+		if (_sqes == MAP_FAILED) {
+			_sqes = nullptr;
+			ThrowError(errno);
+		}
+
+		// Find the ring fields within the mappings.
+		Byte* sq = (Byte*)_sq_ring;
+		_sq_head = (unsigned int*)(sq + params.sq_off.head);
+		_sq_tail = (unsigned int*)(sq + params.sq_off.tail);
+		_sq_mask = *(unsigned int*)(sq + params.sq_off.ring_mask);
+		_sq_entries = *(unsigned int*)(sq + params.sq_off.ring_entries);
+		_sq_array = (unsigned int*)(sq + params.sq_off.array);
+
+		Byte* cq = (Byte*)_cq_ring;
+		_cq_head = (unsigned int*)(cq + params.cq_off.head);
+		_cq_tail = (unsigned int*)(cq + params.cq_off.tail);
+		_cq_mask = *(unsigned int*)(cq + params.cq_off.ring_mask);
+		_cq_entries = *(unsigned int*)(cq + params.cq_off.ring_entries);
+		_cqes = cq + params.cq_off.cqes;
+
+		// Register the file, so that the kernel doesn't need to look up the descriptor for every request.
+		int fd = _file.Handle();
+		if (IoUringRegister(_ring_fd, IORING_REGISTER_FILES, &fd, 1) < 0)
+			ThrowError(errno);
+
+	}
+
+}
+
+#endif
\ No newline at end of file
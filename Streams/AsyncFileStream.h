@@ -0,0 +1,119 @@
+#pragma once
+#include "IO.h"
+#include "FileStream.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace IO {
+
+	// Describes a buffer registered with an AsyncFileStream.
+	struct AsyncBuffer {
+		// The address of the buffer.
+		void* data;
+		// The size of the buffer in bytes.
+		size_t length;
+	};
+
+	// Describes the result of a completed asynchronous read or write.
+	struct AsyncCompletion {
+		// The value passed when the request was queued.
+		uint64_t user_data;
+		// The number of bytes transferred, or a negated errno value if the request failed.
+		long long result;
+	};
+
+	// Provides asynchronous, positional reads and writes on a file using io_uring.
+	// Requests are queued in batches, submitted to the kernel with a single system call, and their completions are collected later.
+	// Available on Linux only.
+	class AsyncFileStream {
+
+	public:
+		// Initializes a new instance of the AsyncFileStream class with the specified path and creation mode.
+		AsyncFileStream(const char* path, FileMode mode);
+		// Initializes a new instance of the AsyncFileStream class with the specified path, creation mode, and read/write permission.
+		AsyncFileStream(const char* path, FileMode mode, FileAccess access);
+		// Initializes a new instance of the AsyncFileStream class that can hold up to "queue_depth" queued requests.
+		AsyncFileStream(const char* path, FileMode mode, FileAccess access, unsigned int queue_depth);
+		AsyncFileStream(const AsyncFileStream& other) = delete;
+		// Waits for any requests still in flight, and releases all resources used by the stream.
+		~AsyncFileStream();
+
+		// Gets the length in bytes of the file.
+		size_t Length();
+		// Sets the length of the file.
+		void SetLength(size_t length);
+		// Gets the number of requests that have been queued, but not yet submitted.
+		size_t Queued() const;
+		// Gets the number of requests that have been submitted, but whose completions have not been retrieved.
+		size_t InFlight() const;
+
+		// Queues a read of "length" bytes at the given position in the file. Returns false if the queue is full. Throws ArgumentException if the length is 4 GiB or more.
+		bool QueueRead(void* buffer, size_t length, size_t position, uint64_t user_data);
+		// Queues a write of "length" bytes at the given position in the file. Returns false if the queue is full. Throws ArgumentException if the length is 4 GiB or more.
+		bool QueueWrite(const void* buffer, size_t length, size_t position, uint64_t user_data);
+		// Queues a read into the registered buffer with the given index, beginning "offset" bytes into the buffer. Returns false if the queue is full.
+		bool QueueReadFixed(unsigned int buffer_index, size_t offset, size_t length, size_t position, uint64_t user_data);
+		// Queues a write from the registered buffer with the given index, beginning "offset" bytes into the buffer. Returns false if the queue is full.
+		bool QueueWriteFixed(unsigned int buffer_index, size_t offset, size_t length, size_t position, uint64_t user_data);
+		// Submits all queued requests to the kernel, and returns the number of requests submitted.
+		size_t Submit();
+		// Submits all queued requests, and waits until at least "min_completions" requests have completed.
+		size_t SubmitAndWait(size_t min_completions);
+		// Retrieves up to "max_completions" completions without waiting. Returns the number of completions retrieved.
+		size_t PollCompletions(AsyncCompletion* completions, size_t max_completions);
+		// Retrieves up to "max_completions" completions, waiting until at least "min_completions" are available. Returns the number of completions retrieved.
+		size_t WaitCompletions(AsyncCompletion* completions, size_t max_completions, size_t min_completions = 1);
+
+		// Registers buffers with the kernel so that they can be used with QueueReadFixed and QueueWriteFixed. Replaces any previously registered buffers.
+		void RegisterBuffers(const AsyncBuffer* buffers, size_t count);
+		// Unregisters all buffers registered with RegisterBuffers.
+		void UnregisterBuffers();
+
+		// Waits for any requests in flight, and closes the file.
+		void Close();
+
+		AsyncFileStream& operator=(const AsyncFileStream& other) = delete;
+
+	protected:
+		// Reserves the next submission queue entry and fills in the fields common to all requests, or returns null if the queue is full.
+		void* NextEntry(uint8_t opcode, size_t length, size_t position, uint64_t user_data);
+		// Enters the kernel to submit queued requests and/or wait for completions.
+		size_t Enter(size_t min_completions);
+
+	private:
+		// Creates the ring and maps its queues into memory.
+		void InitRing(unsigned int queue_depth);
+
+		// The underlying file.
+		FileStream _file;
+		// The io_uring file descriptor.
+		int _ring_fd;
+		// The memory-mapped submission and completion queue rings, and submission queue entries.
+		void* _sq_ring;
+		size_t _sq_ring_size;
+		void* _cq_ring;
+		size_t _cq_ring_size;
+		void* _sqes;
+		size_t _sqes_size;
+		// Pointers into the mapped rings.
+		unsigned int* _sq_head;
+		unsigned int* _sq_tail;
+		unsigned int _sq_mask;
+		unsigned int* _sq_array;
+		unsigned int _sq_entries;
+		unsigned int* _cq_head;
+		unsigned int* _cq_tail;
+		unsigned int _cq_mask;
+		void* _cqes;
+		unsigned int _cq_entries;
+		// The number of requests queued but not yet submitted.
+		size_t _queued;
+		// The number of requests submitted but not yet retrieved.
+		size_t _in_flight;
+		// The registered buffers.
+		std::vector<AsyncBuffer> _buffers;
+
+	};
+
+}
\ No newline at end of file
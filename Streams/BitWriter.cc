@@ -1,6 +1,7 @@
 #include "BitWriter.h"
 #include "Exception.h"
 #include <cstdlib>
+#include <cstring>
 #include <algorithm>
 #include <cassert>
 #include <iostream>
@@ -9,23 +10,31 @@ namespace IO {
 
 	// Public methods
 
-	BitWriter::BitWriter() {
+	BitWriter::BitWriter() : BitWriter(BufferPool::Shared()) {}
+	BitWriter::BitWriter(Allocator& allocator) {
 
 		_stream = nullptr;
 		_owns_stream = false;
+		_allocator = &allocator;
 		_buffer = nullptr;
+		_buffer_size = 0;
 		_byte_offset = 0;
 		_bit_offset = 0;
+		_initialized = 0;
 
 		// Set buffer to 64-bits initially, which should be enough to contain most primitive types.
-		_buffer_size = 8;
-		AllocateBuffer(_buffer_size);
+		AllocateBuffer(8);
 
 	}
 	BitWriter::BitWriter(IStream& stream) : BitWriter() {
 
 		_stream = &stream;
 
+	}
+	BitWriter::BitWriter(IStream& stream, Allocator& allocator) : BitWriter(allocator) {
+
+		_stream = &stream;
+
 	}
 	BitWriter::~BitWriter() {
 
@@ -34,7 +43,7 @@ namespace IO {
 
 		// Free the write buffer if one has been allocated.
 		if (_buffer)
-			free(_buffer);
+			_allocator->Deallocate(_buffer, _buffer_size);
 
 	}
 
@@ -122,8 +131,9 @@ namespace IO {
 		// Seek by the number of bytes.
 		Seek(bytes);
 
-		// Fill the write buffer with data from the stream.
+		// Fill the write buffer with data from the stream. Bits are written over the existing bytes, so these count as initialized.
 		long long bytes_read = _stream->Read(_buffer, 0, _buffer_size);
+		_initialized = (size_t)bytes_read;
 
 		// Seek back to the original position.
 		Seek(-bytes_read, SeekOrigin::Current);
@@ -243,26 +253,23 @@ namespace IO {
 	}
 	void BitWriter::AllocateBuffer(size_t bytes) {
 
-		// Create a new buffer.
-		Byte* new_buffer = (Byte*)calloc(bytes, sizeof(Byte));
-
-		// If the buffer isn't empty, copy the contents of the old buffer into the new buffer.
-		if (_buffer != nullptr && (_byte_offset > 0 || _bit_offset > 0))
-			memcpy(new_buffer, _buffer, _byte_offset > 0 ? _byte_offset : 1);
-
-		// Free the old buffer (if it exists).
-		if (_buffer != nullptr)
-			free(_buffer);
+		// Resize the buffer, keeping its contents. This lets allocators that can grow a block in place (such as an arena) avoid a copy.
+		// The new memory is not zeroed here; WriteBits clears each byte when it first writes to it.
+		Byte* new_buffer = (Byte*)_allocator->Reallocate(_buffer, _buffer_size, bytes);
+		if (_initialized > bytes)
+			_initialized = bytes;
 
 		// Apply the new buffer.
 		_buffer = new_buffer;
+		_buffer_size = bytes;
 
 	}
 	void BitWriter::ClearBuffer() {
 
-		// Zero-out the portion of the buffer we've written to.
-		size_t length = _byte_offset + (_bit_offset > 0);
-		memset(_buffer, 0, length);
+		// If anything has been written, mark the buffer as uninitialized rather than zeroing it, since WriteBits clears each byte as it reaches it.
+		// Otherwise, leave it alone, since it may hold bytes just read from the stream by SeekBits.
+		if (_byte_offset > 0 || _bit_offset > 0)
+			_initialized = 0;
 
 		// Reset buffer offsets.
 		_byte_offset = 0;
@@ -295,6 +302,8 @@ namespace IO {
 
 		// If we're writing a single byte and the bit offset is 0, write it directly.
 		if (bits == 8 && !_bit_offset) {
+			if (_byte_offset >= _initialized)
+				_initialized = _byte_offset + 1;
 			_buffer[_byte_offset++] = value;
 			if (_byte_offset == _buffer_size)
 				FlushWrite();
@@ -303,6 +312,11 @@ namespace IO {
 
 		// Write "bits" least-significant bits from the value.
 		for (int i = bits - 1; i >= 0; --i) {
+			// Bits are OR'd into the buffer, so clear each byte the first time it is written to.
+			if (_byte_offset >= _initialized) {
+				_buffer[_byte_offset] = 0;
+				_initialized = _byte_offset + 1;
+			}
 			_buffer[_byte_offset] |= ((value >> i) & 1) << (7 - _bit_offset);
 			IncrementBitOffset();
 		}
@@ -1,5 +1,6 @@
 #pragma once
 #include "IStream.h"
+#include "BufferPool.h"
 #include <climits>
 #include <stdint.h>
 #include <string>
@@ -10,6 +11,8 @@ namespace IO {
 
 	public:
 		BitWriter(IStream& stream);
+		// Initializes a new instance of the BitWriter class that allocates its write buffer with the given allocator (for example, a BufferPool or an ArenaAllocator).
+		BitWriter(IStream& stream, Allocator& allocator);
 		~BitWriter();
 
 		// Gets the underlying stream of the BitWriter.
@@ -60,11 +63,12 @@ namespace IO {
 
 	protected:
 		BitWriter();
+		BitWriter(Allocator& allocator);
 		// Flushes all data in the write buffer to the underlying stream.
 		void FlushWrite();
 		// Creates a new write buffer of "bytes" bytes, and copies any existing data into the new buffer.
 		void AllocateBuffer(size_t bytes);
-		// Clears the write buffer by setting every byte to 0.
+		// Clears the write buffer. Bytes are zeroed lazily, as they are first written to.
 		void ClearBuffer();
 		// Returns the number of unwritten bits remaining in the write buffer.
 		size_t BitsRemaining() const;
@@ -77,6 +81,8 @@ namespace IO {
 		// The underlying stream.
 		IStream* _stream;
 		bool _owns_stream;
+		// The allocator used for the write buffer.
+		Allocator* _allocator;
 		// The buffer used for writing.
 		Byte* _buffer;
 		// The site of the write buffer.
@@ -85,6 +91,8 @@ namespace IO {
 		size_t _byte_offset;
 		// The curret bit offset into the write buffer.
 		Byte _bit_offset;
+		// The number of bytes at the start of the write buffer that have been zeroed or filled from the stream. Later bytes are uninitialized.
+		size_t _initialized;
 
 	};
 
@@ -1,26 +1,71 @@
 #include "Buffer.h"
+#include "Simd.h"
 #include <cstdlib>
 #include <cstring>
 #include <algorithm>
 #include <cassert>
+#include <cstddef>
 
 namespace IO {
 
-	Buffer::Buffer(size_t bytes, bool zero) {
+	namespace {
+
+		// Returns the alignment in bytes for the given value, or 0 if the alignment of the allocator is sufficient.
+		size_t AlignmentBytes(BufferAlignment alignment) {
+
+			size_t bytes = 0;
+			switch (alignment) {
+			case BufferAlignment::Bytes16:
+				bytes = 16;
+				break;
+			case BufferAlignment::Bytes32:
+				bytes = 32;
+				break;
+			case BufferAlignment::Bytes64:
+				bytes = 64;
+				break;
+			case BufferAlignment::Page:
+				bytes = PageSize();
+				break;
+			default:
+				break;
+			}
+
+			// Allocators already align blocks for any fundamental type.
+			return bytes > alignof(std::max_align_t) ? bytes : 0;
 
+		}
+
+	}
+
+	Buffer::Buffer(size_t bytes, bool zero) : Buffer(bytes, Allocator::Default(), zero) {}
+	Buffer::Buffer(size_t bytes, Allocator& allocator, bool zero) : Buffer(bytes, BufferAlignment::Default, 0, allocator, zero) {}
+	Buffer::Buffer(size_t bytes, BufferAlignment alignment, size_t padding, bool zero) : Buffer(bytes, alignment, padding, Allocator::Default(), zero) {}
+	Buffer::Buffer(size_t bytes, BufferAlignment alignment, size_t padding, Allocator& allocator, bool zero) {
+
+		_allocator = &allocator;
 		_size = bytes;
+		_alignment = AlignmentBytes(alignment);
+		_padding = padding;
+		_offset = 0;
 
-		if (bytes > 0)
+		if (bytes > 0) {
+			_buffer = _allocateBuffer(bytes);
 			if (zero)
-				_buffer = (Byte*)calloc(bytes, sizeof(Byte));
-			else
-				_buffer = (Byte*)malloc(bytes);
+				memset(_buffer, 0, bytes);
+		}
 		else
 			_buffer = nullptr;
 
 	}
-	Buffer::Buffer(const Buffer& other) :
-		Buffer(other.Size(), false) {
+	Buffer::Buffer(const Buffer& other) {
+
+		_allocator = &Allocator::Default();
+		_size = other._size;
+		_alignment = other._alignment;
+		_padding = other._padding;
+		_offset = 0;
+		_buffer = _size > 0 ? _allocateBuffer(_size) : nullptr;
 
 		if (_buffer != nullptr)
 			memcpy(_buffer, other._buffer, _size);
@@ -28,8 +73,12 @@ namespace IO {
 	}
 	Buffer::Buffer(Buffer&& other) {
 
+		_allocator = other._allocator;
 		_buffer = other._buffer;
 		_size = other._size;
+		_alignment = other._alignment;
+		_padding = other._padding;
+		_offset = other._offset;
 
 		other._buffer = nullptr;
 		other._size = 0;
@@ -72,13 +121,15 @@ namespace IO {
 	}
 	void Buffer::Rotate(int amount) {
 
-		if (amount < 0)
-			amount += _size;
-		amount %= _size;
+		if (!_buffer || _size == 0)
+			return;
+
+		// Rotating backwards by n is the same as rotating forwards by the remainder of the buffer.
+		size_t distance = static_cast<size_t>((std::abs)((long long)amount)) % _size;
+		if (amount < 0 && distance > 0)
+			distance = _size - distance;
 
-		Reverse(0, _size - amount);
-		Reverse(_size - amount, amount);
-		Reverse(0, _size);
+		RotateBytes(_buffer, _size, distance);
 
 	}
 	void Buffer::Fill(Byte value) {
@@ -121,8 +172,7 @@ namespace IO {
 		if (!_buffer || length <= 0)
 			return;
 
-		for (size_t i = index, j = index + length - 1; i < j; ++i, --j)
-			std::swap(*(_buffer + i), *(_buffer + j));
+		ReverseBytes(_buffer + index, length);
 
 	}
 	void Buffer::Resize(size_t bytes, bool zero) {
@@ -130,34 +180,50 @@ namespace IO {
 		// If the size is zero, simply free the current buffer.
 		if (bytes == 0) {
 
-			// Free the current buffer.
-			if (_buffer)
-				free(_buffer);
-
-			// Set members to null.
-			_buffer = nullptr;
-			_size = 0;
+			_freeBuffer();
 
 			return;
 
 		}
 
-		if (_buffer) {
+		if (_buffer && _alignment > 0) {
+
+			// The allocator can't keep the alignment when it moves the block, so allocate an aligned buffer and copy the contents over.
+			size_t size = _size;
+			size_t offset = _offset;
+			Byte* buffer = _buffer;
+
+			_buffer = _allocateBuffer(bytes);
+			memcpy(_buffer, buffer, (std::min)(size, bytes));
+			_allocator->Deallocate(buffer - offset, _allocationSize(size));
+
+			// Zero-out the new memory (if there is new memory).
+			if (zero && bytes > size)
+				memset(_buffer + size, 0, bytes - size);
+
+		}
+		else if (_buffer) {
 
 			// Reallocate the buffer's memory.
-			_buffer = (Byte*)realloc(_buffer, bytes);
+			_buffer = (Byte*)_allocator->Reallocate(_buffer, _allocationSize(_size), _allocationSize(bytes));
 
 			// Zero-out the new memory (if there is new memory).
 			if (zero && bytes > _size)
 				memset(_buffer + _size, 0, bytes - _size);
 
+			// Clear the padding, which now starts somewhere else.
+			if (_padding > 0)
+				memset(_buffer + bytes, 0, _padding);
+
+		}
+		else {
+
+			// If the buffer has yet to be created, create a new buffer, and zero it if requested.
+			_buffer = _allocateBuffer(bytes);
+			if (zero)
+				memset(_buffer, 0, bytes);
+
 		}
-		else if (zero)
-			// If the buffer has yet to be created, create a new zeroed buffer.
-			_buffer = (Byte*)calloc(bytes, sizeof(Byte));
-		else
-			// If the buffer has yet to be created, create a new unitialized buffer.
-			_buffer = (Byte*)malloc(bytes);
 
 		// Update the size.
 		_size = bytes;
@@ -175,6 +241,16 @@ namespace IO {
 
 		return _size;
 
+	}
+	size_t Buffer::Alignment() const {
+
+		return _alignment > 0 ? _alignment : alignof(std::max_align_t);
+
+	}
+	size_t Buffer::Padding() const {
+
+		return _padding;
+
 	}
 	Buffer::Byte* Buffer::Pointer() const {
 
@@ -194,8 +270,16 @@ namespace IO {
 		if (this == &other)
 			return *this;
 
-		Resize(other.Size());
-		memcpy(_buffer, other._buffer, _size);
+		// Adopt the other buffer's alignment and padding, as the copy constructor does. The old buffer must be freed first, since its allocation size depends on them.
+		_freeBuffer();
+
+		_alignment = other._alignment;
+		_padding = other._padding;
+		_buffer = other._size > 0 ? _allocateBuffer(other._size) : nullptr;
+		_size = other._size;
+
+		if (_buffer != nullptr)
+			memcpy(_buffer, other._buffer, _size);
 
 		return *this;
 
@@ -207,8 +291,12 @@ namespace IO {
 
 		_freeBuffer();
 
+		_allocator = other._allocator;
 		_buffer = other._buffer;
 		_size = other._size;
+		_alignment = other._alignment;
+		_padding = other._padding;
+		_offset = other._offset;
 
 		other._buffer = nullptr;
 		other._size = 0;
@@ -226,10 +314,30 @@ namespace IO {
 	void Buffer::_freeBuffer() {
 
 		if (_buffer != nullptr)
-			free(_buffer);
+			_allocator->Deallocate(_buffer - _offset, _allocationSize(_size));
 
 		_buffer = nullptr;
 		_size = 0;
+		_offset = 0;
+
+	}
+	Buffer::Byte* Buffer::_allocateBuffer(size_t bytes) {
+
+		Byte* block = (Byte*)_allocator->Allocate(_allocationSize(bytes));
+
+		// Move the start of the buffer forward to the next aligned address within the block.
+		Byte* buffer = _alignment > 0 ? (Byte*)AlignUp((size_t)(uintptr_t)block, _alignment) : block;
+		_offset = buffer - block;
+
+		if (_padding > 0)
+			memset(buffer + bytes, 0, _padding);
+
+		return buffer;
+
+	}
+	size_t Buffer::_allocationSize(size_t bytes) const {
+
+		return bytes + _padding + (_alignment > 0 ? _alignment - 1 : 0);
 
 	}
 
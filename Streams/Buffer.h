@@ -1,21 +1,44 @@
 #pragma once
+#include "Allocator.h"
 #include <stdint.h>
 
 namespace IO {
 
+	// Defines the alignment of the memory allocated for a Buffer.
+	enum class BufferAlignment {
+		// Aligned for any fundamental type.
+		Default,
+		// Aligned for 128-bit vectors.
+		Bytes16,
+		// Aligned for 256-bit vectors.
+		Bytes32,
+		// Aligned for 512-bit vectors and cache lines.
+		Bytes64,
+		// Aligned to a virtual memory page, as required for unbuffered (direct) I/O.
+		Page
+	};
+
 	class Buffer {
 
 		typedef uint8_t Byte;
 
 	public:
 		Buffer(size_t bytes, bool zero = false);
+		// Initializes a new buffer whose memory is allocated with the given allocator.
+		Buffer(size_t bytes, Allocator& allocator, bool zero = false);
+		// Initializes a new buffer whose memory has the given alignment, followed by "padding" zeroed bytes so that vector loads can run past the end of the buffer.
+		// The alignment and padding are kept when the buffer is resized.
+		Buffer(size_t bytes, BufferAlignment alignment, size_t padding = 0, bool zero = false);
+		// Initializes a new buffer whose memory has the given alignment and padding, and is allocated with the given allocator.
+		Buffer(size_t bytes, BufferAlignment alignment, size_t padding, Allocator& allocator, bool zero = false);
+		// Initializes a new buffer with a copy of the other buffer's contents. The copy has the same alignment and padding, but uses the default allocator, since the other buffer's allocator may not outlive it.
 		Buffer(const Buffer& other);
 		Buffer(Buffer&& other);
 		~Buffer();
 
 		// Shifts the contents of the buffer by the given amount.
 		void Shift(int amount);
-		// Rotates the contents of the buffer by the given amount.
+		// Rotates the contents of the buffer by the given amount. Positive amounts move bytes towards the end of the buffer. Uses vector instructions where available.
 		void Rotate(int amount);
 		// Sets every byte in the buffer to the given value.
 		void Fill(Byte value);
@@ -27,9 +50,9 @@ namespace IO {
 		void Clear();
 		// Clears all memory in the range by setting every byte to 0.
 		void Clear(size_t index, size_t length);
-		// Reverses the contents of the buffer.
+		// Reverses the contents of the buffer. Uses vector instructions where available.
 		void Reverse();
-		// Reverses the contents of the buffer in the given range.
+		// Reverses the contents of the buffer in the given range. Uses vector instructions where available.
 		void Reverse(size_t index, size_t length);
 		// Resizes the buffer to the given size, and copies the original memory to the new buffer.
 		void Resize(size_t bytes, bool zero = false);
@@ -37,6 +60,10 @@ namespace IO {
 		void Reserve(size_t bytes, bool zero = false);
 		// Returns the size of the buffer in bytes.
 		size_t Size() const;
+		// Returns the alignment in bytes guaranteed for the address of the buffer.
+		size_t Alignment() const;
+		// Returns the number of bytes allocated past the end of the buffer.
+		size_t Padding() const;
 		// Returns the address of the underlying memory segment.
 		Byte* Pointer() const;
 		// Returns the value of the byte at the given index.
@@ -46,10 +73,21 @@ namespace IO {
 		operator Byte*() const;
 
 	private:
+		Allocator* _allocator;
 		Byte* _buffer;
 		size_t _size;
+		// The alignment requested for the buffer, or 0 if the allocator's alignment is sufficient.
+		size_t _alignment;
+		// The number of bytes allocated past the end of the buffer.
+		size_t _padding;
+		// The distance from the start of the allocated block to the aligned buffer.
+		size_t _offset;
 
 		void _freeBuffer();
+		// Allocates an aligned, padded buffer of the given size, and zeroes its padding.
+		Byte* _allocateBuffer(size_t bytes);
+		// Returns the number of bytes to allocate for a buffer of the given size, including padding and room to align it.
+		size_t _allocationSize(size_t bytes) const;
 
 	};
 
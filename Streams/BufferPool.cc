@@ -0,0 +1,240 @@
+#include "BufferPool.h"
+#include <cstdlib>
+#include <atomic>
+#include <memory>
+#include <new>
+
+namespace IO {
+
+	// Free buffers cached by a single thread for a single pool.
+	// Buffers are plain heap allocations, so a cache that outlives its pool can still safely free them when the thread exits.
+	struct BufferPool::ThreadCache {
+
+		uint64_t pool_id;
+		std::weak_ptr<void> pool_alive;
+		std::vector<std::vector<Byte*>> free_lists;
+
+		ThreadCache(uint64_t id, const std::shared_ptr<void>& alive, size_t size_classes) :
+			pool_id(id),
+			pool_alive(alive),
+			free_lists(size_classes) {}
+		~ThreadCache() {
+
+			for (auto& list : free_lists)
+				for (Byte* buffer : list)
+					free(buffer);
+
+		}
+
+	};
+
+	namespace {
+
+		// Pool identifiers are never reused, so a stale thread cache can never be mistaken for the cache of a new pool.
+		std::atomic<uint64_t> next_pool_id(1);
+
+		// The caches owned by the calling thread, one per pool that the thread has used.
+		template<typename T>
+		std::vector<std::unique_ptr<T>>& ThreadCaches() {
+
+			thread_local std::vector<std::unique_ptr<T>> caches;
+			return caches;
+
+		}
+
+	}
+
+	// Public methods
+
+	BufferPool::BufferPool() : BufferPool(1024 * 1024, 32) {}
+	BufferPool::BufferPool(size_t max_buffer_size, size_t max_buffers) {
+
+		_id = next_pool_id++;
+		_alive = std::make_shared<bool>(true);
+		_max_buffers = max_buffers;
+
+		// Round the maximum buffer size up to the nearest size class.
+		_max_buffer_size = (size_t)1 << MIN_SIZE_CLASS_SHIFT;
+		while (_max_buffer_size < max_buffer_size)
+			_max_buffer_size <<= 1;
+
+		_free_lists.resize(SizeClass(_max_buffer_size) + 1);
+
+	}
+	BufferPool::~BufferPool() {
+
+		// Free the buffers held by the global free list.
+		for (auto& list : _free_lists)
+			for (Byte* buffer : list)
+				free(buffer);
+
+		// Thread caches for this pool are freed when their thread exits, or the next time their thread creates a cache for another pool.
+		_alive.reset();
+
+	}
+
+	Byte* BufferPool::Rent(size_t minimum_size) {
+
+		// Buffers that are too large to pool are allocated directly.
+		if (minimum_size > _max_buffer_size) {
+
+			Byte* buffer = (Byte*)malloc(minimum_size);
+			if (!buffer)
+				throw std::bad_alloc();
+
+			return buffer;
+
+		}
+
+		size_t size_class = SizeClass(minimum_size);
+
+		// Try the thread cache first, since it does not require any synchronization.
+		std::vector<Byte*>& local = LocalCache().free_lists[size_class];
+		if (!local.empty()) {
+			Byte* buffer = local.back();
+			local.pop_back();
+			return buffer;
+		}
+
+		// Fall back to the global free list.
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			std::vector<Byte*>& global = _free_lists[size_class];
+			if (!global.empty()) {
+				Byte* buffer = global.back();
+				global.pop_back();
+				return buffer;
+			}
+		}
+
+		// There are no free buffers in this size class, so allocate a new one.
+		Byte* buffer = (Byte*)malloc(BucketSize(minimum_size));
+		if (!buffer)
+			throw std::bad_alloc();
+
+		return buffer;
+
+	}
+	void BufferPool::Return(Byte* buffer, size_t size) {
+
+		if (!buffer)
+			return;
+
+		// Buffers that are too large to pool are freed directly.
+		if (size > _max_buffer_size) {
+			free(buffer);
+			return;
+		}
+
+		size_t size_class = SizeClass(size);
+
+		// Keep the buffer in the thread cache if there is room for it.
+		std::vector<Byte*>& local = LocalCache().free_lists[size_class];
+		if (local.size() < THREAD_CACHE_SIZE) {
+			local.push_back(buffer);
+			return;
+		}
+
+		// Otherwise, return it to the global free list, or free it if the global free list is full.
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			std::vector<Byte*>& global = _free_lists[size_class];
+			if (global.size() < _max_buffers) {
+				global.push_back(buffer);
+				return;
+			}
+		}
+
+		free(buffer);
+
+	}
+	void* BufferPool::Allocate(size_t bytes) {
+
+		return Rent(bytes);
+
+	}
+	void* BufferPool::Reallocate(void* address, size_t old_bytes, size_t new_bytes) {
+
+		// The buffer already has room for the new size if it belongs to the same size class.
+		if (address && old_bytes <= _max_buffer_size && new_bytes <= _max_buffer_size && BucketSize(old_bytes) == BucketSize(new_bytes))
+			return address;
+
+		return Allocator::Reallocate(address, old_bytes, new_bytes);
+
+	}
+	void BufferPool::Deallocate(void* address, size_t bytes) {
+
+		Return((Byte*)address, bytes);
+
+	}
+	void BufferPool::Trim() {
+
+		for (auto& list : LocalCache().free_lists) {
+			for (Byte* buffer : list)
+				free(buffer);
+			list.clear();
+		}
+
+		std::lock_guard<std::mutex> lock(_mutex);
+		for (auto& list : _free_lists) {
+			for (Byte* buffer : list)
+				free(buffer);
+			list.clear();
+		}
+
+	}
+	size_t BufferPool::BucketSize(size_t size) const {
+
+		if (size > _max_buffer_size)
+			return size;
+
+		return (size_t)1 << (SizeClass(size) + MIN_SIZE_CLASS_SHIFT);
+
+	}
+	size_t BufferPool::MaxBufferSize() const {
+
+		return _max_buffer_size;
+
+	}
+
+	BufferPool& BufferPool::Shared() {
+
+		static BufferPool pool;
+		return pool;
+
+	}
+
+	// Protected methods
+
+	size_t BufferPool::SizeClass(size_t size) const {
+
+		size_t size_class = 0;
+		while (((size_t)1 << (size_class + MIN_SIZE_CLASS_SHIFT)) < size)
+			++size_class;
+
+		return size_class;
+
+	}
+
+	// Private methods
+
+	BufferPool::ThreadCache& BufferPool::LocalCache() {
+
+		auto& caches = ThreadCaches<ThreadCache>();
+		for (auto& cache : caches)
+			if (cache->pool_id == _id)
+				return *cache;
+
+		// Free any caches belonging to pools that have since been destroyed.
+		for (auto it = caches.begin(); it != caches.end();)
+			if ((*it)->pool_alive.expired())
+				it = caches.erase(it);
+			else
+				++it;
+
+		caches.emplace_back(new ThreadCache(_id, _alive, _free_lists.size()));
+		return *caches.back();
+
+	}
+
+}
\ No newline at end of file
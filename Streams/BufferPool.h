@@ -0,0 +1,78 @@
+#pragma once
+#include "IO.h"
+#include "Allocator.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace IO {
+
+	// Provides a pool of reusable byte buffers grouped into power-of-two size classes.
+	// Buffers are cached per-thread first, and fall back to a global (locked) free list shared by all threads.
+	// The pool can also be used as an Allocator, in which case blocks are rented and returned.
+	class BufferPool : public Allocator {
+
+	public:
+		// Initializes a new instance of the BufferPool class with the default limits.
+		BufferPool();
+		// Initializes a new instance of the BufferPool class that pools buffers up to the given size, keeping at most "max_buffers" free buffers per size class.
+		BufferPool(size_t max_buffer_size, size_t max_buffers);
+		BufferPool(const BufferPool& other) = delete;
+		// Releases all buffers held by the pool.
+		virtual ~BufferPool();
+
+		// Returns a buffer that is at least "minimum_size" bytes long. The contents of the buffer are undefined.
+		virtual Byte* Rent(size_t minimum_size);
+		// Returns a buffer to the pool. The size must be the same size that was passed to Rent.
+		virtual void Return(Byte* buffer, size_t size);
+		// Releases all free buffers held by the global free list and the calling thread's cache.
+		virtual void Trim();
+		// Rents a buffer of at least "bytes" bytes.
+		virtual void* Allocate(size_t bytes) override;
+		// Rents a buffer of the new size and copies the contents into it, unless both sizes fall into the same size class.
+		virtual void* Reallocate(void* address, size_t old_bytes, size_t new_bytes) override;
+		// Returns a buffer to the pool.
+		virtual void Deallocate(void* address, size_t bytes) override;
+		// Returns the actual size of the buffers returned by Rent for the given size.
+		size_t BucketSize(size_t size) const;
+		// Returns the largest buffer size that will be pooled. Larger buffers are allocated and freed directly.
+		size_t MaxBufferSize() const;
+
+		BufferPool& operator=(const BufferPool& other) = delete;
+
+		// Returns the process-wide shared pool.
+		static BufferPool& Shared();
+
+	protected:
+		// Returns the index of the size class containing buffers of the given size.
+		size_t SizeClass(size_t size) const;
+
+	private:
+		// The smallest size class is 2^MIN_SIZE_CLASS_SHIFT bytes.
+		static const size_t MIN_SIZE_CLASS_SHIFT = 4;
+		// The number of buffers kept in each thread's cache for a single size class.
+		static const size_t THREAD_CACHE_SIZE = 8;
+
+		struct ThreadCache;
+
+		// Returns the calling thread's cache for this pool, creating it if necessary.
+		ThreadCache& LocalCache();
+
+		// A unique identifier used to find this pool's per-thread caches.
+		uint64_t _id;
+		// Expires when the pool is destroyed, allowing threads to discard their caches for it.
+		std::shared_ptr<void> _alive;
+		// The largest buffer size that is pooled.
+		size_t _max_buffer_size;
+		// The maximum number of free buffers held by the global free list per size class.
+		size_t _max_buffers;
+		// Free buffers shared by all threads, indexed by size class.
+		std::vector<std::vector<Byte*>> _free_lists;
+		// Protects the global free lists.
+		std::mutex _mutex;
+
+	};
+
+}
\ No newline at end of file
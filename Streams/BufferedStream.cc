@@ -2,13 +2,17 @@
 #include "Exception.h"
 #include <cstdlib>
 #include <cassert>
+#include <cstring>
+#include <vector>
 
 namespace IO {
 
 	BufferedSteam::BufferedSteam(IStream& stream) : BufferedSteam(stream, 4096) {}
-	BufferedSteam::BufferedSteam(IStream& stream, size_t buffer_size) {
+	BufferedSteam::BufferedSteam(IStream& stream, size_t buffer_size) : BufferedSteam(stream, buffer_size, BufferPool::Shared()) {}
+	BufferedSteam::BufferedSteam(IStream& stream, size_t buffer_size, BufferPool& pool) {
 
 		_stream = &stream;
+		_pool = &pool;
 		_buffer = nullptr;
 		_buffer_size = buffer_size;
 		_read_offset = 0;
@@ -89,7 +93,7 @@ namespace IO {
 	bool BufferedSteam::ReadByte(Byte& byte) {
 
 		// If the stream is null, there are no bytes to read.
-		if (_stream)
+		if (!_stream)
 			return false;
 
 		// If the read buffer is empty and the stream does not support reading, throw an exception.
@@ -104,8 +108,7 @@ namespace IO {
 				FlushWrite();
 
 			// If a buffer has not been allocated, allocate it now.
-			if (!_buffer)
-				_buffer = (Byte*)malloc(_buffer_size);
+			AllocateBuffer();
 
 			// Read bytes into the buffer, and reset the read position.
 			_read_length = _stream->Read(_buffer, 0, _buffer_size);
@@ -143,8 +146,7 @@ namespace IO {
 			}
 
 			// Create the buffer if it doesn't already exist.
-			if (!_buffer)
-				_buffer = (Byte*)malloc(_buffer_size);
+			AllocateBuffer();
 
 		}
 
@@ -192,8 +194,7 @@ namespace IO {
 			}
 
 			// Allocate the read buffer if it hasn't already been allocated.
-			if (!_buffer)
-				_buffer = (Byte*)malloc(_buffer_size);
+			AllocateBuffer();
 
 			// Read from the stream into the buffer.
 			bytes_read = _stream->Read(_buffer, 0, _buffer_size);
@@ -257,7 +258,7 @@ namespace IO {
 					bytes_left = length;
 
 				// Fill up the write buffer (as much as we can).
-				memcpy((Byte*)buffer + offset * sizeof(Byte), _buffer + _write_offset * sizeof(Byte), bytes_left);
+				memcpy(_buffer + _write_offset * sizeof(Byte), (const Byte*)buffer + offset * sizeof(Byte), bytes_left);
 				_write_offset += bytes_left;
 
 				// If we could fit all of the bytes into the buffer, return here.
@@ -287,24 +288,87 @@ namespace IO {
 			return;
 
 		// Allocate the write buffer if it hasn't already been allocated.
-		if (!_buffer)
-			_buffer = (Byte*)malloc(_buffer_size);
+		AllocateBuffer();
 
 		// Copy the remaining bytes into the buffer.
 		memcpy(_buffer, (Byte*)buffer + offset * sizeof(Byte), length);
 		_write_offset = length;
 
+	}
+	void BufferedSteam::WriteV(const ConstSpan* spans, size_t count) {
+
+		// If the stream is null, throw an exception.
+		if (!_stream)
+			throw InvalidOperationException();
+
+		if (_write_offset == 0) {
+
+			// If the stream does not support writing, throw an exception.
+			if (!_stream->CanWrite())
+				throw NotSupportedException();
+
+			// Flush reads performed on the buffer.
+			if (_read_offset < _read_length)
+				FlushRead();
+			else {
+				_read_offset = 0;
+				_read_length = 0;
+			}
+
+		}
+
+		// Get the total number of bytes to write.
+		size_t length = 0;
+		for (size_t i = 0; i < count; ++i)
+			length += spans[i].length;
+
+		// If all of the spans fit in the write buffer, coalesce them there.
+		if (_write_offset + length <= _buffer_size) {
+
+			AllocateBuffer();
+
+			for (size_t i = 0; i < count; ++i) {
+				memcpy(_buffer + _write_offset * sizeof(Byte), spans[i].data, spans[i].length);
+				_write_offset += spans[i].length;
+			}
+
+			return;
+
+		}
+
+		// Otherwise, write the contents of the buffer followed by the spans with a single vectored write to the underlying stream.
+		std::vector<ConstSpan> all;
+		all.reserve(count + 1);
+		if (_write_offset > 0)
+			all.push_back(ConstSpan{ _buffer, (size_t)_write_offset });
+		all.insert(all.end(), spans, spans + count);
+
+		_stream->WriteV(all.data(), all.size());
+		_write_offset = 0;
+
 	}
 	void BufferedSteam::Close() {
 
-		// Dispose of the buffer if it was allocated.
+		// Return the buffer to the pool if it was allocated.
 		if (_buffer)
-			free(_buffer);
+			_pool->Return(_buffer, _buffer_size);
 		_buffer = nullptr;
 
 		// Set stream to null.
 		_stream = nullptr;
 
+	}
+	void BufferedSteam::Advise(AccessPattern pattern, size_t offset, size_t length) {
+
+		if (_stream)
+			_stream->Advise(pattern, offset, length);
+
+	}
+	void BufferedSteam::Prefetch(size_t offset, size_t length) {
+
+		if (_stream)
+			_stream->Prefetch(offset, length);
+
 	}
 	size_t BufferedSteam::Seek(long long offset, SeekOrigin origin) {
 
@@ -409,5 +473,11 @@ namespace IO {
 		_stream->Flush();
 
 	}
+	void BufferedSteam::AllocateBuffer() {
+
+		if (!_buffer)
+			_buffer = _pool->Rent(_buffer_size);
+
+	}
 
 }
\ No newline at end of file
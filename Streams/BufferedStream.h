@@ -1,4 +1,5 @@
 #include "IStream.h"
+#include "BufferPool.h"
 
 namespace IO {
 
@@ -7,6 +8,7 @@ namespace IO {
 	public:
 		BufferedSteam(IStream& stream);
 		BufferedSteam(IStream& stream, size_t buffer_size);
+		BufferedSteam(IStream& stream, size_t buffer_size, BufferPool& pool);
 		~BufferedSteam();
 
 		// Gets the length in bytes of the stream.
@@ -25,8 +27,14 @@ namespace IO {
 		size_t Read(void* buffer, size_t offset, size_t length) override;
 		// Copies bytes to the buffered stream and advances the current position within the buffered stream by the number of bytes written.
 		void Write(const void* buffer, size_t offset, size_t length) override;
+		// Copies the contents of the given spans to the buffered stream. Spans that fit in the buffer are coalesced there; otherwise the buffered bytes and the spans are written to the underlying stream together.
+		void WriteV(const ConstSpan* spans, size_t count) override;
 		// Closes the current stream and releases any resources associated with the current stream.
 		void Close() override;
+		// Passes the access pattern for the given range on to the underlying stream.
+		void Advise(AccessPattern pattern, size_t offset, size_t length) override;
+		// Asks the underlying stream to prefetch the given range.
+		void Prefetch(size_t offset, size_t length) override;
 		// Sets the position within the current buffered stream.
 		size_t Seek(long long offset, SeekOrigin origin) override;
 		// Sets the position within the current buffered stream.
@@ -43,10 +51,14 @@ namespace IO {
 		void FlushRead();
 		// Flushes writes performed on the buffer to the underlying stream.
 		void FlushWrite();
+		// Rents the buffer from the buffer pool if it has not already been allocated.
+		void AllocateBuffer();
 
 	private:
 		// The underlying stream.
 		IStream* _stream;
+		// The pool that the buffer is rented from.
+		BufferPool* _pool;
 		// The buffer, shared for both read/write operations.
 		Byte* _buffer;
 		// The size of the buffer.
@@ -0,0 +1,216 @@
+#include "FileHandleCache.h"
+#include "Exception.h"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#ifdef _WIN32
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace IO {
+
+	namespace {
+
+		// The number of unused descriptors kept open by default.
+		const size_t DEFAULT_CAPACITY = 128;
+
+		std::string MakeKey(const char* path, FileAccess access) {
+
+			std::string key(path);
+			key.push_back('\0');
+			key.push_back((char)access);
+
+			return key;
+
+		}
+		int OpenHandle(const char* path, FileAccess access, bool create) {
+
+			int flags = access == FileAccess::Read ? O_RDONLY : access == FileAccess::Write ? O_WRONLY : O_RDWR;
+			if (create)
+				flags |= O_CREAT;
+
+#ifdef _WIN32
+			return _open(path, flags | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+			return open(path, flags | O_CLOEXEC, 0666);
+#endif
+
+		}
+		void CloseHandle(int handle) {
+
+#ifdef _WIN32
+			_close(handle);
+#else
+			close(handle);
+#endif
+
+		}
+
+	}
+
+	FileHandleCache::FileHandleCache() : FileHandleCache(DEFAULT_CAPACITY) {}
+	FileHandleCache::FileHandleCache(size_t capacity) {
+
+		_capacity = capacity;
+
+	}
+	FileHandleCache::~FileHandleCache() {
+
+		for (auto& entry : _entries)
+			CloseHandle(entry.first);
+
+	}
+
+	int FileHandleCache::Acquire(const char* path, FileAccess access, bool create) {
+
+		std::string key = MakeKey(path, access);
+
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+
+			// If the file is already open, share its descriptor.
+			auto it = _handles.find(key);
+			if (it != _handles.end()) {
+				Entry& entry = _entries[it->second];
+				if (entry.references++ == 0)
+					_idle.erase(entry.idle);
+				return it->second;
+			}
+		}
+
+		// Open the file without holding the lock, so that a slow open does not block other streams.
+		int handle = OpenHandle(path, access, create);
+		if (handle < 0) {
+			if (errno == ENOENT)
+				throw FileNotFoundException();
+			throw IOException(std::strerror(errno));
+		}
+
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		// Another thread may have opened the same file in the meantime, in which case use its descriptor instead.
+		auto it = _handles.find(key);
+		if (it != _handles.end()) {
+			CloseHandle(handle);
+			Entry& entry = _entries[it->second];
+			if (entry.references++ == 0)
+				_idle.erase(entry.idle);
+			return it->second;
+		}
+
+		Entry entry;
+		entry.key = key;
+		entry.references = 1;
+		entry.invalidated = false;
+		entry.idle = _idle.end();
+		_handles[key] = handle;
+		_entries[handle] = entry;
+
+		Evict();
+
+		return handle;
+
+	}
+	void FileHandleCache::Release(int handle) {
+
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		auto it = _entries.find(handle);
+		if (it == _entries.end() || it->second.references == 0)
+			throw ArgumentException("The handle was not acquired from this cache.");
+
+		Entry& entry = it->second;
+		if (--entry.references > 0)
+			return;
+
+		// Close invalidated descriptors as soon as they are no longer in use. Otherwise, keep the descriptor open for the next stream.
+		if (entry.invalidated)
+			Remove(handle);
+		else {
+			_idle.push_front(handle);
+			entry.idle = _idle.begin();
+			Evict();
+		}
+
+	}
+	void FileHandleCache::Invalidate(const char* path) {
+
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		FileAccess accesses[] = { FileAccess::Read, FileAccess::ReadWrite, FileAccess::Write };
+		for (FileAccess access : accesses) {
+
+			auto it = _handles.find(MakeKey(path, access));
+			if (it == _handles.end())
+				continue;
+
+			int handle = it->second;
+			_handles.erase(it);
+
+			Entry& entry = _entries[handle];
+			if (entry.references == 0) {
+				_idle.erase(entry.idle);
+				Remove(handle);
+			}
+			else
+				entry.invalidated = true;
+
+		}
+
+	}
+	void FileHandleCache::Clear() {
+
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		while (!_idle.empty()) {
+			int handle = _idle.back();
+			_idle.pop_back();
+			_handles.erase(_entries[handle].key);
+			Remove(handle);
+		}
+
+	}
+	size_t FileHandleCache::Count() const {
+
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		return _entries.size();
+
+	}
+	size_t FileHandleCache::Capacity() const {
+
+		return _capacity;
+
+	}
+
+	FileHandleCache& FileHandleCache::Shared() {
+
+		static FileHandleCache cache;
+		return cache;
+
+	}
+
+	// Private methods
+
+	void FileHandleCache::Evict() {
+
+		// Descriptors in use can't be closed, so the cache may temporarily hold more than its capacity.
+		while (_entries.size() > _capacity && !_idle.empty()) {
+			int handle = _idle.back();
+			_idle.pop_back();
+			_handles.erase(_entries[handle].key);
+			Remove(handle);
+		}
+
+	}
+	void FileHandleCache::Remove(int handle) {
+
+		CloseHandle(handle);
+		_entries.erase(handle);
+
+	}
+
+}
\ No newline at end of file
@@ -0,0 +1,74 @@
+#pragma once
+#include "FileStream.h"
+#include <cstddef>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace IO {
+
+	// Caches open file descriptors by path and access, so that FileStreams opening the same file can share a descriptor instead of opening and closing it each time.
+	// Descriptors are reference counted. Those no longer used by any stream are kept open, up to the cache's capacity, and closed in least-recently-used order.
+	// Since FileStream uses positional I/O, streams sharing a descriptor do not affect each other's positions.
+	class FileHandleCache {
+
+	public:
+		// Initializes a new instance of the FileHandleCache class with the default capacity.
+		FileHandleCache();
+		// Initializes a new instance of the FileHandleCache class that keeps at most "capacity" descriptors open when they are not in use.
+		FileHandleCache(size_t capacity);
+		FileHandleCache(const FileHandleCache& other) = delete;
+		// Closes all cached descriptors. The cache must outlive every stream using it.
+		~FileHandleCache();
+
+		// Returns a descriptor for the given file opened with the given access, opening the file if it is not cached. If "create" is true, the file is created if it does not exist.
+		// The descriptor must be passed to Release when it is no longer needed.
+		int Acquire(const char* path, FileAccess access, bool create);
+		// Releases a descriptor returned by Acquire. The descriptor stays open in the cache until it is evicted.
+		void Release(int handle);
+		// Removes all descriptors for the given path from the cache, for example after the file has been deleted or replaced. Descriptors still in use are closed when they are released.
+		void Invalidate(const char* path);
+		// Closes all descriptors that are not in use.
+		void Clear();
+		// Gets the number of descriptors held by the cache, including those in use.
+		size_t Count() const;
+		// Gets the maximum number of unused descriptors kept open.
+		size_t Capacity() const;
+
+		FileHandleCache& operator=(const FileHandleCache& other) = delete;
+
+		// Returns the process-wide shared cache.
+		static FileHandleCache& Shared();
+
+	private:
+		struct Entry {
+			// The key the entry was cached under.
+			std::string key;
+			// The number of streams using the descriptor.
+			size_t references;
+			// True if the entry has been removed from the cache, and should be closed once it is no longer in use.
+			bool invalidated;
+			// The entry's position in the idle list, if it is not in use.
+			std::list<int>::iterator idle;
+		};
+
+		// Closes idle descriptors until the number of descriptors is within capacity, or none are idle.
+		void Evict();
+		// Closes the given descriptor and removes its entry.
+		void Remove(int handle);
+
+		// The maximum number of unused descriptors kept open.
+		size_t _capacity;
+		// Maps keys (the path and access) to descriptors.
+		std::unordered_map<std::string, int> _handles;
+		// Maps descriptors to their entries.
+		std::unordered_map<int, Entry> _entries;
+		// Descriptors that are not in use, from most to least recently released.
+		std::list<int> _idle;
+		// Protects the members above.
+		mutable std::mutex _mutex;
+
+	};
+
+}
\ No newline at end of file
@@ -1,30 +1,337 @@
 #include "FileStream.h"
 #include "Exception.h"
+#include "BufferPool.h"
+#include "FileHandleCache.h"
 #include <cassert>
+#include <cerrno>
+#include <cstring>
 #include <algorithm>
+#include <vector>
+#include <fcntl.h>
 #include <sys/stat.h>
+#ifdef _WIN32
+#include <io.h>
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <climits>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+#ifdef __linux__
+#include <sys/sendfile.h>
+#endif
 
 namespace IO {
 
+	namespace {
+
+#ifdef _WIN32
+		// The CRT does not provide positional I/O, so use the descriptor's underlying handle with an explicit offset instead. This doesn't depend on the descriptor's file pointer, so it is safe to do from multiple threads.
+
+		typedef long long ssize_t;
+		typedef struct _stat64 stat_t;
+
+		// The largest number of bytes to transfer in a single call.
+		const size_t MAX_TRANSFER_SIZE = 0x7ffff000;
+
+		// Sets errno from the last Windows error.
+		void SetErrnoFromLastError() {
+
+			switch (GetLastError()) {
+			case ERROR_FILE_NOT_FOUND:
+			case ERROR_PATH_NOT_FOUND:
+				errno = ENOENT;
+				break;
+			case ERROR_ACCESS_DENIED:
+				errno = EACCES;
+				break;
+			case ERROR_DISK_FULL:
+			case ERROR_HANDLE_DISK_FULL:
+				errno = ENOSPC;
+				break;
+			case ERROR_INVALID_HANDLE:
+				errno = EBADF;
+				break;
+			default:
+				errno = EIO;
+				break;
+			}
+
+		}
+		OVERLAPPED OffsetOverlapped(size_t offset) {
+
+			OVERLAPPED overlapped = {};
+			overlapped.Offset = (DWORD)((unsigned long long)offset & 0xffffffff);
+			overlapped.OffsetHigh = (DWORD)((unsigned long long)offset >> 32);
+
+			return overlapped;
+
+		}
+		ssize_t PositionalRead(int fd, void* buffer, size_t length, size_t offset) {
+
+			OVERLAPPED overlapped = OffsetOverlapped(offset);
+			DWORD bytes_read = 0;
+
+			if (!ReadFile((HANDLE)_get_osfhandle(fd), buffer, (DWORD)(std::min)(length, MAX_TRANSFER_SIZE), &bytes_read, &overlapped)) {
+				// Reading at or past the end of the file is not an error.
+				if (GetLastError() == ERROR_HANDLE_EOF)
+					return 0;
+				SetErrnoFromLastError();
+				return -1;
+			}
+
+			return (ssize_t)bytes_read;
+
+		}
+		ssize_t PositionalWrite(int fd, const void* buffer, size_t length, size_t offset) {
+
+			OVERLAPPED overlapped = OffsetOverlapped(offset);
+			DWORD bytes_written = 0;
+
+			if (!WriteFile((HANDLE)_get_osfhandle(fd), buffer, (DWORD)(std::min)(length, MAX_TRANSFER_SIZE), &bytes_written, &overlapped)) {
+				SetErrnoFromLastError();
+				return -1;
+			}
+
+			return (ssize_t)bytes_written;
+
+		}
+		ssize_t AppendWrite(int fd, const void* buffer, size_t length) {
+
+			return _write(fd, buffer, (unsigned int)length);
+
+		}
+		int OpenFile(const char* path, int flags) {
+
+			return _open(path, flags | _O_BINARY, _S_IREAD | _S_IWRITE);
+
+		}
+		int CloseFile(int fd) {
+
+			return _close(fd);
+
+		}
+		int StatFile(int fd, stat_t* buf) {
+
+			return _fstat64(fd, buf);
+
+		}
+		int TruncateFile(int fd, size_t length) {
+
+			errno = _chsize_s(fd, (long long)length);
+			return errno == 0 ? 0 : -1;
+
+		}
+#else
+		typedef struct stat stat_t;
+
+		ssize_t PositionalRead(int fd, void* buffer, size_t length, size_t offset) {
+
+			return pread(fd, buffer, length, (off_t)offset);
+
+		}
+		ssize_t PositionalWrite(int fd, const void* buffer, size_t length, size_t offset) {
+
+			return pwrite(fd, buffer, length, (off_t)offset);
+
+		}
+		ssize_t AppendWrite(int fd, const void* buffer, size_t length) {
+
+			return write(fd, buffer, length);
+
+		}
+		int OpenFile(const char* path, int flags) {
+
+			return open(path, flags | O_CLOEXEC, 0666);
+
+		}
+		int CloseFile(int fd) {
+
+			return close(fd);
+
+		}
+		int StatFile(int fd, stat_t* buf) {
+
+			return fstat(fd, buf);
+
+		}
+		int TruncateFile(int fd, size_t length) {
+
+			return ftruncate(fd, (off_t)length);
+
+		}
+		ssize_t PositionalReadV(int fd, const iovec* iov, size_t count, size_t offset) {
+
+			return preadv(fd, iov, (int)(std::min)(count, (size_t)IOV_MAX), (off_t)offset);
+
+		}
+		ssize_t PositionalWriteV(int fd, const iovec* iov, size_t count, size_t offset) {
+
+			return pwritev(fd, iov, (int)(std::min)(count, (size_t)IOV_MAX), (off_t)offset);
+
+		}
+		ssize_t AppendWriteV(int fd, const iovec* iov, size_t count) {
+
+			return writev(fd, iov, (int)(std::min)(count, (size_t)IOV_MAX));
+
+		}
+		// Advances the given vector past "bytes" bytes that have been transferred, returning the index of the first incomplete entry.
+		size_t AdvanceIovecs(std::vector<iovec>& iov, size_t index, size_t bytes) {
+
+			while (bytes > 0 && index < iov.size()) {
+				if (bytes >= iov[index].iov_len) {
+					bytes -= iov[index].iov_len;
+					++index;
+				}
+				else {
+					iov[index].iov_base = (Byte*)iov[index].iov_base + bytes;
+					iov[index].iov_len -= bytes;
+					bytes = 0;
+				}
+			}
+
+			return index;
+
+		}
+#endif
+
+		// Copies up to "length" bytes from one file to another within the kernel, trying copy_file_range, sendfile, and splice in turn.
+		// An "output_position" of -1 writes at the end of an output file opened for appending. Returns the number of bytes copied, which is less than "length" if the kernel could not copy the rest.
+		size_t KernelCopy(int input_fd, size_t input_position, int output_fd, long long output_position, size_t length) {
+
+			size_t copied = 0;
+
+#ifdef __linux__
+			// The maximum number of bytes to request in a single call.
+			const size_t max_chunk = 0x7ffff000;
+
+			// copy_file_range copies between arbitrary offsets, and lets the filesystem share extents instead of copying them. It cannot write to files opened for appending.
+			while (output_position >= 0 && copied < length) {
+				loff_t input_offset = (loff_t)(input_position + copied);
+				loff_t output_offset = (loff_t)(output_position + copied);
+				ssize_t result = copy_file_range(input_fd, &input_offset, output_fd, &output_offset, (std::min)(length - copied, max_chunk), 0);
+				if (result < 0 && errno == EINTR)
+					continue;
+				if (result <= 0)
+					break;
+				copied += (size_t)result;
+			}
+
+			// sendfile writes at the output file's offset, so move it to the output position first.
+			if (copied < length && (output_position < 0 || lseek(output_fd, (off_t)(output_position + copied), SEEK_SET) >= 0)) {
+				while (copied < length) {
+					off_t input_offset = (off_t)(input_position + copied);
+					ssize_t result = sendfile(output_fd, input_fd, &input_offset, (std::min)(length - copied, max_chunk));
+					if (result < 0 && errno == EINTR)
+						continue;
+					if (result <= 0)
+						break;
+					copied += (size_t)result;
+				}
+			}
+
+			// Finally, splice the data through a pipe, which still keeps it within the kernel.
+			int pipe_fds[2];
+			if (copied < length && pipe(pipe_fds) == 0) {
+				while (copied < length) {
+					loff_t input_offset = (loff_t)(input_position + copied);
+					ssize_t in_pipe = splice(input_fd, &input_offset, pipe_fds[1], nullptr, (std::min)(length - copied, max_chunk), SPLICE_F_MOVE);
+					if (in_pipe < 0 && errno == EINTR)
+						continue;
+					if (in_pipe <= 0)
+						break;
+					// Drain the pipe into the output file. If that fails, the data in the pipe is discarded and will be copied again by the caller.
+					ssize_t drained = 0;
+					while (drained < in_pipe) {
+						loff_t output_offset = (loff_t)(output_position + copied + drained);
+						ssize_t result = splice(pipe_fds[0], nullptr, output_fd, output_position < 0 ? nullptr : &output_offset, (size_t)(in_pipe - drained), SPLICE_F_MOVE);
+						if (result < 0 && errno == EINTR)
+							continue;
+						if (result <= 0)
+							break;
+						drained += result;
+					}
+					copied += (size_t)drained;
+					if (drained < in_pipe)
+						break;
+				}
+				close(pipe_fds[0]);
+				close(pipe_fds[1]);
+			}
+#endif
+
+			return copied;
+
+		}
+
+		// The size of the staging buffer used for unaligned direct I/O.
+		const size_t DIRECT_BUFFER_SIZE = 1024 * 1024;
+
+		// An aligned staging buffer owned by a single direct I/O call, large enough for the blocks covering the given range (up to DIRECT_BUFFER_SIZE).
+		// The memory is rented from the shared pool, so that concurrent calls don't allocate on every call.
+		struct StagingBuffer {
+			Byte* data;
+			Byte* rented;
+			size_t rented_size;
+			StagingBuffer(size_t position, size_t length) {
+				size_t size = (std::min)(AlignUp(position + length, FileStream::DIRECT_IO_ALIGNMENT) - AlignDown(position, FileStream::DIRECT_IO_ALIGNMENT), DIRECT_BUFFER_SIZE);
+				rented_size = size + FileStream::DIRECT_IO_ALIGNMENT;
+				rented = BufferPool::Shared().Rent(rented_size);
+				data = (Byte*)AlignUp((size_t)(uintptr_t)rented, FileStream::DIRECT_IO_ALIGNMENT);
+			}
+			~StagingBuffer() { BufferPool::Shared().Return(rented, rented_size); }
+		};
+
+		// Throws an exception describing the error in errno.
+		[[noreturn]] void ThrowLastError() {
+
+			if (errno == ENOENT)
+				throw FileNotFoundException();
+
+			throw IOException(std::strerror(errno));
+
+		}
+
+	}
+
+	const size_t FileStream::DIRECT_IO_ALIGNMENT;
+
 	FileStream::FileStream(const char* path, FileMode mode) : FileStream(path, mode, FileAccess::ReadWrite) {}
-	FileStream::FileStream(const char* path, FileMode mode, FileAccess access) {
+	FileStream::FileStream(const char* path, FileMode mode, FileAccess access) : FileStream(path, mode, access, FileOptions::None) {}
+	FileStream::FileStream(const char* path, FileMode mode, FileAccess access, FileOptions options) {
 
 		// Initialize member variables.
+		_fd = -1;
 		_position = 0;
+		_length = 0;
 		_path = path;
-		_last_read = false;
+		_direct_buffer = nullptr;
+		_cache = nullptr;
 
 		// Initialize flags.
-		InitFlags(mode, access);
+		InitFlags(mode, access, options);
 
 		// Open the file.
-		_stream.open(path, _flags);
-	
-		// If opened in "Append" mode, seek to the end of the file.
-		if (_flags & std::fstream::app) {
-			_stream.seekg(0, std::ios_base::end);
-			_position = (size_t)_stream.tellg();
-		}
+		Open(path, nullptr);
+
+	}
+	FileStream::FileStream(const char* path, FileMode mode, FileAccess access, FileHandleCache& cache) {
+
+		// Initialize member variables.
+		_fd = -1;
+		_position = 0;
+		_length = 0;
+		_path = path;
+		_direct_buffer = nullptr;
+		_cache = nullptr;
+
+		// Initialize flags.
+		InitFlags(mode, access, FileOptions::None);
+
+		// Open the file. Exclusive creation and appending depend on flags that can't be shared, so those modes always open the file directly.
+		Open(path, mode == FileMode::CreateNew || mode == FileMode::Append ? nullptr : &cache);
 
 	}
 	FileStream::~FileStream() {
@@ -35,36 +342,40 @@ namespace IO {
 
 	size_t FileStream::Length() {
 
-		// If the stream is in "Append" mode, just return the current position (guaranteed to be at the end of the stream).
-		if (_flags & std::fstream::app)
-			return _position;
-
-		// If the stream does not support reading, throw an error.
-		if (!CanRead())
-			throw NotSupportedException();
+		return _length;
 
-		// Preserve the current seek position.
-		std::streampos pos = _stream.tellg();
+	}
+	size_t FileStream::Position() const {
 
-		// Seek to the end of the stream, and record the size.
-		_stream.seekg(0, std::ios::end);
-		std::streampos size = _stream.tellg();
+		return _position;
 
-		// Seek back to the previous position.
-		_stream.seekg(pos, std::ios::beg);
+	}
+	int FileStream::Handle() const {
 
-		// Return the file size.
-		return size < 0 ? 0 : (size_t)size;
+		return _fd;
 
 	}
-	size_t FileStream::Position() const {
+	void FileStream::Flush() {}
+	void FileStream::Sync(SyncMode mode) {
 
-		return _position;
+		if (_fd < 0)
+			throw NotSupportedException();
 
-	}
-	void FileStream::Flush() {
+		int result;
+
+#ifdef _WIN32
+		result = _commit(_fd);
+#elif defined(F_FULLFSYNC)
+		// On macOS, fsync does not flush the drive's write cache, so a full sync needs F_FULLFSYNC.
+		result = mode == SyncMode::Full ? fcntl(_fd, F_FULLFSYNC) : fsync(_fd);
+#elif defined(_POSIX_SYNCHRONIZED_IO) && _POSIX_SYNCHRONIZED_IO > 0
+		result = mode == SyncMode::Data ? fdatasync(_fd) : fsync(_fd);
+#else
+		result = fsync(_fd);
+#endif
 
-		_stream.flush();
+		if (result < 0)
+			ThrowLastError();
 
 	}
 	void FileStream::SetLength(size_t length) {
@@ -73,138 +384,364 @@ namespace IO {
 		if (!CanWrite() || !CanSeek())
 			throw NotSupportedException();
 
-		// Get the current length.
-		size_t clength = Length();
+		// Truncate or extend the file in place. Extended regions read as zeros, and do not take up space on file systems supporting sparse files.
+		while (TruncateFile(_fd, length) < 0)
+			if (errno != EINTR)
+				ThrowLastError();
+
+		_length = length;
 
-		if (length < clength) {
+		// If the length is less than the seek position, move seek position to end.
+		if (_position > _length)
+			_position = _length;
 
-			// Create a buffer, and copy into it the first length bytes of the file.
-			Byte* buf = new Byte[length];
-			size_t prev_pos = _position;
-			Seek(0, IO::SeekOrigin::Begin);
-			Read(buf, 0, length);
+	}
+	void FileStream::Preallocate(size_t length) {
 
-			// Close the file stream.
-			_stream.flush();
-			_stream.close();
+		// Throw error if the stream does not support writing or seeking.
+		if (!CanWrite() || !CanSeek())
+			throw NotSupportedException();
 
-			// Create a new file stream with the truncation flag.
-			_stream.open(_path, std::fstream::out | std::fstream::trunc);
+#ifdef __linux__
 
-			// Write the buffer back to the file, and free it.
-			_position = 0;
-			Write(buf, 0, length);
-			delete[] buf;
+		// Allocate the blocks with fallocate, falling back to posix_fallocate if the file system doesn't support it.
+		// posix_fallocate emulates the allocation by writing to each block, which is slower but has the same effect.
+		if (fallocate(_fd, 0, 0, (off_t)length) < 0) {
 
-			// Close the file.
-			_stream.flush();
-			_stream.close();
+			if (errno != EOPNOTSUPP && errno != ENOSYS)
+				ThrowLastError();
 
-			// Re-open the file with previous flags, and seek the former or truncated position.
-			_stream.open(_path, _flags);
-			_last_read = false;
-			_stream.seekg((std::min)(prev_pos, length));
+			int error = posix_fallocate(_fd, 0, (off_t)length);
+			if (error != 0) {
+				errno = error;
+				ThrowLastError();
+			}
 
 		}
-		else if (length > clength) {
 
-			// Seek to the desired length, write a null byte, and then seek back.
-			_stream.seekg(-1 + length);
-			_stream.write("\0", 1);
-			_stream.seekg(_position);
+		ExtendLength(length);
 
-		}
+#else
+
+		// Disk space can't be reserved explicitly on this platform, so just make sure the file is long enough.
+		if (length > _length)
+			SetLength(length);
+
+#endif
 
 	}
 	bool FileStream::ReadByte(Byte& byte) {
 
+		return Read(&byte, 0, 1) == 1;
+
+	}
+	void FileStream::WriteByte(Byte byte) {
+
+		Write(&byte, 0, 1);
+
+	}
+	size_t FileStream::Read(void* buffer, size_t offset, size_t length) {
+
 		// Throw an exception of the stream is not readable.
 		if (!CanRead())
 			throw NotSupportedException();
 
-		// If the last action was not a read, seek to refresh the stream.
-		if (!_last_read) _stream.seekg(_position);
-		_last_read = true;
+		// Read bytes from the file into the buffer.
+		size_t bytes_read = ReadFromFile((Byte*)buffer + offset * sizeof(Byte), length, _position);
 
-		// Attempt to read a byte from the Stream.
-		char b;
-		_stream.read(&b, 1);
-
-		// If we've reached the end of the Stream, a valid character was not read.
-		if (_stream.eof() || b == -1)
-			return false;
-
-		// Set the value read, and increment the seek position.
-		byte = b;
-		++_position;
+		// Update the seek position.
+		_position += bytes_read;
 
-		// Return true, since a byte was successfully read.
-		return true;
+		return bytes_read;
 
 	}
-	void FileStream::WriteByte(Byte byte) {
+	void FileStream::Write(const void* buffer, size_t offset, size_t length) {
 
 		// Throw an exception of the stream is not writeable.
 		if (!CanWrite())
 			throw NotSupportedException();
 
-		// If the last action was not a write, seek to refresh the stream.
-		if (_last_read) _stream.seekg(_position);
-		_last_read = false;
+		// Write bytes from the buffer to the file.
+		WriteToFile((const Byte*)buffer + offset * sizeof(Byte), length, _position);
 
-		_stream.write((const char*)&byte, 1);
-		++_position;
+		// Update the seek position and length.
+		_position += length;
+		ExtendLength(_position);
 
 	}
-	size_t FileStream::Read(void* buffer, size_t offset, size_t length) {
+	void FileStream::CopyTo(IStream& stream) {
+
+		CopyTo(stream, DEFAULT_COPY_BUFFER_SIZE);
+
+	}
+	void FileStream::CopyTo(IStream& stream, size_t buffer_size) {
+
+		// Let the destination specialize the copy if it is able to.
+		if (stream.CopyFrom(*this, buffer_size))
+			return;
+
+		IStream::CopyTo(stream, buffer_size);
+
+	}
+	void FileStream::CopyTo(FileStream& stream) {
+
+		CopyTo(stream, DEFAULT_COPY_BUFFER_SIZE);
+
+	}
+	void FileStream::CopyTo(FileStream& stream, size_t buffer_size) {
+
+		// Throw an exception of the stream is not readable, or the output stream is not writeable.
+		if (!CanRead() || !stream.CanWrite())
+			throw NotSupportedException();
+
+		if (_position < _length)
+			CopyRange(stream, _length - _position, buffer_size);
+
+		// Copy anything written to the file by others since the length was last known.
+		IStream::CopyTo(stream, buffer_size);
+
+	}
+	void FileStream::CopyTo(FileStream& stream, CopyMode mode) {
+
+		// Holes can only be reproduced if the destination can be written at arbitrary positions.
+		if (mode == CopyMode::Dense || !stream.CanSeek()) {
+			CopyTo(stream);
+			return;
+		}
+
+		// Throw an exception of the stream is not readable, or the output stream is not writeable.
+		if (!CanRead() || !stream.CanWrite())
+			throw NotSupportedException();
+
+		size_t start = _position;
+		size_t end = (std::max)(_length.load(), _position);
+		size_t output_start = stream._position;
+
+		// Copy each region of data, skipping over the holes between them.
+		size_t offset = start;
+		while (offset < end) {
+
+			size_t data = (std::min)(FindData(offset), end);
+			size_t hole = (std::min)(FindHole(data), end);
+
+			// If the destination already has contents where the hole is, punch a matching hole so the old contents are not left behind.
+			size_t output_hole = output_start + (offset - start);
+			if (data > offset && output_hole < stream._length)
+				stream.PunchHole(output_hole, (std::min)(data - offset, stream._length - output_hole));
+
+			if (hole > data) {
+				_position = data;
+				stream._position = output_start + (data - start);
+				CopyRange(stream, hole - data, DEFAULT_COPY_BUFFER_SIZE);
+			}
+
+			offset = hole;
+
+		}
+
+		// If the file ends with a hole, extend the destination to the same length without writing anything.
+		_position = end;
+		stream._position = output_start + (end - start);
+		if (stream._position > stream._length)
+			stream.SetLength(stream._position);
+
+	}
+	bool FileStream::CopyFrom(FileStream& stream, size_t buffer_size) {
+
+		stream.CopyTo(*this, buffer_size);
+
+		return true;
+
+	}
+	size_t FileStream::ReadAt(size_t position, void* buffer, size_t length) {
 
 		// Throw an exception of the stream is not readable.
 		if (!CanRead())
 			throw NotSupportedException();
 
-		// If the last action was not a read, seek to refresh the stream.
-		if (!_last_read) _stream.seekg(_position);
-		_last_read = true;
+		return ReadFromFile(buffer, length, position, true);
+
+	}
+	void FileStream::WriteAt(size_t position, const void* buffer, size_t length) {
+
+		// Throw an exception if the stream is not writeable, or is in "Append" mode (where the position would be ignored).
+		if (!CanWrite() || !CanSeek())
+			throw NotSupportedException();
+
+		WriteToFile(buffer, length, position, true);
+		ExtendLength(position + length);
 
-		// Write bytes from the stream to the buffer.
-		_stream.read((char*)buffer + offset * sizeof(Byte), length);
+	}
+	void FileStream::WriteVAt(size_t position, const ConstSpan* spans, size_t count) {
+
+		// Throw an exception if the stream is not writeable, or is in "Append" mode (where the position would be ignored).
+		if (!CanWrite() || !CanSeek())
+			throw NotSupportedException();
+
+		size_t length = 0;
+		for (size_t i = 0; i < count; ++i)
+			length += spans[i].length;
+
+		WriteVFully(spans, count, position, true);
+		ExtendLength(position + length);
+
+	}
+	size_t FileStream::ReadV(const Span* spans, size_t count) {
+
+		// Throw an exception of the stream is not readable.
+		if (!CanRead())
+			throw NotSupportedException();
+
+		// Read bytes from the file into the spans.
+		size_t bytes_read = ReadVFully(spans, count, _position);
 
 		// Update the seek position.
-		size_t bytes_read = (size_t)_stream.gcount();
 		_position += bytes_read;
 
 		return bytes_read;
 
 	}
-	void FileStream::Write(const void* buffer, size_t offset, size_t length) {
+	void FileStream::WriteV(const ConstSpan* spans, size_t count) {
 
 		// Throw an exception of the stream is not writeable.
 		if (!CanWrite())
 			throw NotSupportedException();
 
-		// If the last action was not a write, seek to refresh the stream.
-		if (_last_read) _stream.seekg(_position);
-		_last_read = false;
-
-		// Write bytes to the stream from the buffer.
-		_stream.write((const char*)buffer + offset, length);
+		// Write bytes from the spans to the file.
+		WriteVFully(spans, count, _position);
 
-		// Update the sek position.
-		_position += length;
+		// Update the seek position and length.
+		for (size_t i = 0; i < count; ++i)
+			_position += spans[i].length;
+		ExtendLength(_position);
 
 	}
 	void FileStream::Close() {
 
-		// Flush and close the stream if it is open.
-		if (_stream.is_open()) {
-			_stream.flush();
-			_stream.close();
+		// Close the file descriptor if it is open, or return it to the cache it came from.
+		if (_fd >= 0) {
+			if (_cache)
+				_cache->Release(_fd);
+			else
+				CloseFile(_fd);
+			_fd = -1;
+			_cache = nullptr;
 		}
 
+		// Free the direct I/O staging buffer.
+		if (_direct_buffer)
+			FreeAligned(_direct_buffer);
+		_direct_buffer = nullptr;
+
 		// Reset the seek position and flags.
 		_position = 0;
+		_length = 0;
 		_flags = 0;
-		_access_flags = 0;
+
+	}
+	void FileStream::Advise(AccessPattern pattern, size_t offset, size_t length) {
+
+		// Direct I/O bypasses the page cache, so there is nothing to tune.
+		if (_fd < 0 || _options == FileOptions::Direct)
+			return;
+
+#ifdef POSIX_FADV_NORMAL
+
+		int advice = POSIX_FADV_NORMAL;
+		switch (pattern) {
+		case AccessPattern::Normal:
+			advice = POSIX_FADV_NORMAL;
+			break;
+		case AccessPattern::Sequential:
+			advice = POSIX_FADV_SEQUENTIAL;
+			break;
+		case AccessPattern::Random:
+			advice = POSIX_FADV_RANDOM;
+			break;
+		case AccessPattern::WillNeed:
+			advice = POSIX_FADV_WILLNEED;
+			break;
+		case AccessPattern::DontNeed:
+			advice = POSIX_FADV_DONTNEED;
+			break;
+		}
+
+		// posix_fadvise returns the error number rather than setting errno.
+		int error = posix_fadvise(_fd, (off_t)offset, (off_t)length, advice);
+		if (error != 0) {
+			errno = error;
+			ThrowLastError();
+		}
+
+#endif
+
+	}
+	void FileStream::Prefetch(size_t offset, size_t length) {
+
+		if (_fd < 0 || _options == FileOptions::Direct)
+			return;
+
+#ifdef __linux__
+
+		// readahead requires an explicit length, so a length of zero means the rest of the file.
+		if (length == 0)
+			length = offset < _length ? _length - offset : 0;
+
+		if (readahead(_fd, (off64_t)offset, length) < 0)
+			ThrowLastError();
+
+#else
+
+		Advise(AccessPattern::WillNeed, offset, length);
+
+#endif
+
+	}
+	void FileStream::PunchHole(size_t offset, size_t length) {
+
+		// Throw error if the stream does not support writing or seeking.
+		if (!CanWrite() || !CanSeek())
+			throw NotSupportedException();
+
+		// Holes never extend the file.
+		if (offset >= _length)
+			return;
+		length = (std::min)(length, _length - offset);
+
+#if defined(__linux__) && defined(FALLOC_FL_PUNCH_HOLE)
+		if (fallocate(_fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, (off_t)offset, (off_t)length) == 0)
+			return;
+
+		if (errno != EOPNOTSUPP && errno != ENOSYS)
+			ThrowLastError();
+#endif
+
+		// The file system doesn't support holes, so overwrite the range with zeros, which reads the same.
+		std::vector<Byte> zeros((std::min)(length, DEFAULT_COPY_BUFFER_SIZE), 0);
+		for (size_t written = 0; written < length; written += zeros.size()) {
+			size_t count = (std::min)(zeros.size(), length - written);
+			WriteToFile(zeros.data(), count, offset + written);
+		}
+
+	}
+	size_t FileStream::SeekData(size_t offset) {
+
+		if (!CanSeek())
+			throw NotSupportedException();
+
+		_position = FindData(offset);
+
+		return _position;
+
+	}
+	size_t FileStream::SeekHole(size_t offset) {
+
+		if (!CanSeek())
+			throw NotSupportedException();
+
+		_position = FindHole(offset);
+
+		return _position;
 
 	}
 	size_t FileStream::Seek(long long offset, SeekOrigin origin) {
@@ -213,27 +750,23 @@ namespace IO {
 		if (!CanSeek()) throw
 			IO::IOException();
 
-		// For fstream, seekg and seekp refer to the same pointer, and do not need to be considered separately.
-
-		// Store the current stream position (to compute difference later).
-		std::streampos pos = _stream.tellg();
-
-		// Determine the seek origin.
-		std::ios_base::seekdir seek_origin = std::ios_base::beg;
+		// Get the origin position from the seek origin.
+		long long origin_position = 0;
 		switch (origin) {
 		case SeekOrigin::Current:
-			seek_origin = std::ios_base::cur;
+			origin_position = (long long)_position;
 			break;
 		case SeekOrigin::End:
-			seek_origin = std::ios_base::end;
+			origin_position = (long long)_length;
 			break;
 		}
 
-		// Move the seek pointer.
-		_stream.seekg(offset, seek_origin);
+		// Throw an error if the new position is less than 0.
+		if (origin_position + offset < 0)
+			throw IOException("An attempt was made to move the position before the beginning of the stream.");
 
-		// Adjust the seek position according to the difference.
-		_position += (size_t)(_stream.tellg() - pos);
+		// Apply the new position. Nothing is sent to the file until the next read or write.
+		_position = (size_t)(origin_position + offset);
 
 		// Return the new position.
 		return _position;
@@ -246,76 +779,481 @@ namespace IO {
 	}
 	bool FileStream::CanRead() const {
 
-		return (_access_flags & std::fstream::in) && !(_flags & std::fstream::app) && _stream.is_open();
+		return _access != FileAccess::Write && !_append && _fd >= 0;
 
 	}
 	bool FileStream::CanSeek() const {
 
-		return !(_flags & std::fstream::app) && _stream.is_open();
+		return !_append && _fd >= 0;
 
 	}
 	bool FileStream::CanWrite() const {
 
-		return (_access_flags & std::fstream::out) && _stream.is_open();
+		return _access != FileAccess::Read && _fd >= 0;
+
+	}
+	bool FileStream::CanAccessConcurrently() const {
+
+		return _fd >= 0;
 
 	}
 
-	bool FileStream::FileExists(const char* path) {
+	// Protected methods
+
+	void FileStream::Open(const char* path, FileHandleCache* cache) {
 
-		struct stat buf;
-		return (stat(path, &buf) != -1);
+		if (cache) {
+
+			_fd = cache->Acquire(path, _access, (_flags & O_CREAT) != 0);
+			_cache = cache;
+
+			// The shared descriptor wasn't opened with O_TRUNC, so truncate the file explicitly.
+			if ((_flags & O_TRUNC) && TruncateFile(_fd, 0) < 0) {
+				int error = errno;
+				Close();
+				errno = error;
+				ThrowLastError();
+			}
+
+		}
+		else {
+
+			_fd = OpenFile(path, _flags);
+			if (_fd < 0)
+				ThrowLastError();
+
+		}
+
+		// Get the initial length of the file. This is cached, so that Length() doesn't need to query the file.
+		stat_t buf;
+		if (StatFile(_fd, &buf) < 0) {
+			int error = errno;
+			Close();
+			errno = error;
+			ThrowLastError();
+		}
+		_length = (size_t)buf.st_size;
+
+		// If opened in "Append" mode, start at the end of the file.
+		if (_append)
+			_position = _length;
 
 	}
-	void FileStream::InitFlags(FileMode mode, FileAccess access) {
+	void FileStream::InitFlags(FileMode mode, FileAccess access, FileOptions options) {
 
 		// Initialize variables.
-		_flags = std::fstream::binary;
-		_access_flags = 0;
+		_access = access;
+		_append = false;
+		_options = options;
 
 		// Set access flags.
 		switch (access) {
 		case FileAccess::Read:
-			_access_flags |= std::fstream::in;
+			_flags = O_RDONLY;
 			break;
 		case FileAccess::ReadWrite:
-			_access_flags |= std::fstream::in;
+			_flags = O_RDWR;
+			break;
 		case FileAccess::Write:
-			_access_flags |= std::fstream::out;
+			_flags = O_WRONLY;
 			break;
 		}
 
-		// Set mode flags.
+		// Set mode flags. Existence checks are left to open(), which reports them through errno.
 		switch (mode) {
 
 		case FileMode::Append:
-			_flags |= std::fstream::app | std::fstream::out;
+			_flags = O_WRONLY | O_CREAT | O_APPEND;
+			_access = FileAccess::Write;
+			_append = true;
 			break;
 
 		case FileMode::Open:
-			if (!FileExists(_path.c_str()))
-				throw FileNotFoundException();
-			_flags |= _access_flags;
 			break;
 
 		case FileMode::OpenOrCreate:
-			if (FileExists(_path.c_str()))
-				_flags |= _access_flags;
-			else
-				_flags |= std::fstream::out;
+			_flags |= O_CREAT;
 			break;
 
 		case FileMode::CreateNew:
-			if (FileExists(_path.c_str()))
-				throw IO::IOException();
+			_flags |= O_CREAT | O_EXCL;
+			break;
 
 		case FileMode::Create:
 
 		case FileMode::Truncate:
-			_flags |= std::fstream::trunc | _access_flags;
+			_flags |= O_CREAT | O_TRUNC;
 			break;
 
 		}
 
+		// Set option flags.
+		if (options == FileOptions::Direct) {
+
+#ifdef O_DIRECT
+			// Unaligned writes need to read the surrounding blocks, so a writable file must also be readable. Read-only files are left read-only.
+			// Direct writes in "Append" mode are made at the cached length instead of using O_APPEND, which doesn't work with O_DIRECT.
+			if ((_flags & O_ACCMODE) == O_WRONLY)
+				_flags = (_flags & ~(O_WRONLY | O_APPEND)) | O_RDWR;
+			_flags |= O_DIRECT;
+#else
+			throw NotSupportedException("Direct I/O is not supported on this platform.");
+#endif
+
+		}
+
+	}
+	size_t FileStream::ReadFromFile(void* buffer, size_t length, size_t position, bool concurrent) {
+
+		// Direct reads of unaligned ranges need to go through a staging buffer.
+		if (_options == FileOptions::Direct &&
+			!(IsAligned(buffer, DIRECT_IO_ALIGNMENT) && IsAligned(length, DIRECT_IO_ALIGNMENT) && IsAligned(position, DIRECT_IO_ALIGNMENT))) {
+
+			if (!concurrent)
+				return DirectRead(buffer, length, position, DirectBuffer());
+
+			StagingBuffer staging_buffer(position, length);
+			return DirectRead(buffer, length, position, staging_buffer.data);
+
+		}
+
+		return ReadFully(buffer, length, position);
+
+	}
+	void FileStream::WriteToFile(const void* buffer, size_t length, size_t position, bool concurrent) {
+
+		// Direct writes of unaligned ranges need to go through a staging buffer.
+		if (_options == FileOptions::Direct &&
+			!(IsAligned(buffer, DIRECT_IO_ALIGNMENT) && IsAligned(length, DIRECT_IO_ALIGNMENT) && IsAligned(position, DIRECT_IO_ALIGNMENT))) {
+
+			if (!concurrent)
+				DirectWrite(buffer, length, position, DirectBuffer());
+			else {
+				StagingBuffer staging_buffer(position, length);
+				DirectWrite(buffer, length, position, staging_buffer.data);
+			}
+
+			return;
+
+		}
+
+		WriteFully(buffer, length, position);
+
+	}
+	void FileStream::ExtendLength(size_t length) {
+
+		// Other threads may be extending the length at the same time, so only replace it if it is still shorter.
+		size_t current = _length.load();
+		while (current < length && !_length.compare_exchange_weak(current, length)) {}
+
+	}
+
+	// Private methods
+
+	size_t FileStream::FindData(size_t offset) {
+
+		if (offset >= _length)
+			return _length;
+
+#ifdef SEEK_DATA
+		off_t result = lseek(_fd, (off_t)offset, SEEK_DATA);
+		if (result >= 0)
+			return (std::min)((size_t)result, _length.load());
+
+		// ENXIO means there is no more data after the offset. Anything else means holes aren't supported, so the whole file is data.
+		if (errno == ENXIO)
+			return _length;
+#endif
+
+		return offset;
+
+	}
+	size_t FileStream::FindHole(size_t offset) {
+
+		if (offset >= _length)
+			return _length;
+
+#ifdef SEEK_HOLE
+		off_t result = lseek(_fd, (off_t)offset, SEEK_HOLE);
+		if (result >= 0)
+			return (std::min)((size_t)result, _length.load());
+#endif
+
+		return _length;
+
+	}
+	void FileStream::CopyRange(FileStream& stream, size_t length, size_t buffer_size) {
+
+		// Direct I/O requires aligned transfers, so leave it to the buffered copy.
+		if (_options != FileOptions::Direct && stream._options != FileOptions::Direct) {
+
+			long long output_position = stream._append ? -1 : (long long)stream._position;
+			size_t copied = KernelCopy(_fd, _position, stream._fd, output_position, length);
+
+			// Update the seek positions and length.
+			_position += copied;
+			stream._position += copied;
+			stream.ExtendLength(stream._position);
+			length -= copied;
+
+		}
+
+		if (length == 0)
+			return;
+
+		// Copy anything the kernel could not through a buffer.
+		BufferPool& pool = BufferPool::Shared();
+		buffer_size = (std::min)(length, (std::max)(buffer_size, (size_t)1));
+		Byte* buffer = pool.Rent(buffer_size);
+
+		try {
+			size_t bytes_read;
+			while (length > 0 && (bytes_read = Read(buffer, 0, (std::min)(length, buffer_size))) > 0) {
+				stream.Write(buffer, 0, bytes_read);
+				length -= bytes_read;
+			}
+		}
+		catch (...) {
+			pool.Return(buffer, buffer_size);
+			throw;
+		}
+
+		pool.Return(buffer, buffer_size);
+
+	}
+
+	size_t FileStream::ReadFully(void* buffer, size_t length, size_t position) {
+
+		Byte* addr = (Byte*)buffer;
+		size_t bytes_read = 0;
+
+		// Read until we have the requested number of bytes, or reach the end of the file.
+		while (bytes_read < length) {
+
+			ssize_t result = PositionalRead(_fd, addr + bytes_read, length - bytes_read, position + bytes_read);
+
+			if (result < 0) {
+				if (errno == EINTR)
+					continue;
+				ThrowLastError();
+			}
+
+			bytes_read += (size_t)result;
+
+			// Direct reads only come up short at the end of the file (and could not be continued from an unaligned position anyway).
+			if (result == 0 || (_options == FileOptions::Direct && bytes_read < length))
+				break;
+
+		}
+
+		return bytes_read;
+
+	}
+	void FileStream::WriteFully(const void* buffer, size_t length, size_t position) {
+
+		const Byte* addr = (const Byte*)buffer;
+		size_t bytes_written = 0;
+
+		// Write until all bytes have been written. In "Append" mode, the operating system writes to the end of the file.
+		bool append = _append && _options != FileOptions::Direct;
+		while (bytes_written < length) {
+
+			ssize_t result = append ?
+				AppendWrite(_fd, addr + bytes_written, length - bytes_written) :
+				PositionalWrite(_fd, addr + bytes_written, length - bytes_written, position + bytes_written);
+
+			if (result < 0) {
+				if (errno == EINTR)
+					continue;
+				ThrowLastError();
+			}
+
+			bytes_written += (size_t)result;
+
+		}
+
+	}
+	size_t FileStream::ReadVFully(const Span* spans, size_t count, size_t position) {
+
+#ifndef _WIN32
+		// Vectored reads can't be staged, so they are only used for buffered I/O.
+		if (_options != FileOptions::Direct) {
+
+			// Empty spans are skipped, so that a zero-length transfer always means the end of the file.
+			std::vector<iovec> iov;
+			iov.reserve(count);
+			for (size_t i = 0; i < count; ++i)
+				if (spans[i].length > 0)
+					iov.push_back(iovec{ spans[i].data, spans[i].length });
+
+			size_t index = 0;
+			size_t bytes_read = 0;
+			while (index < iov.size()) {
+
+				ssize_t result = PositionalReadV(_fd, &iov[index], iov.size() - index, position + bytes_read);
+
+				if (result < 0) {
+					if (errno == EINTR)
+						continue;
+					ThrowLastError();
+				}
+
+				// Stop if we've reached the end of the file.
+				if (result == 0)
+					break;
+
+				bytes_read += (size_t)result;
+				index = AdvanceIovecs(iov, index, (size_t)result);
+
+			}
+
+			return bytes_read;
+
+		}
+#endif
+
+		// Otherwise, read each span in turn.
+		size_t bytes_read = 0;
+		for (size_t i = 0; i < count; ++i) {
+
+			size_t result = ReadFromFile(spans[i].data, spans[i].length, position + bytes_read);
+			bytes_read += result;
+
+			if (result < spans[i].length)
+				break;
+
+		}
+
+		return bytes_read;
+
+	}
+	void FileStream::WriteVFully(const ConstSpan* spans, size_t count, size_t position, bool concurrent) {
+
+#ifndef _WIN32
+		// Vectored writes can't be staged, so they are only used for buffered I/O.
+		if (_options != FileOptions::Direct) {
+
+			// Empty spans are skipped, so that every write makes progress.
+			std::vector<iovec> iov;
+			iov.reserve(count);
+			for (size_t i = 0; i < count; ++i)
+				if (spans[i].length > 0)
+					iov.push_back(iovec{ (void*)spans[i].data, spans[i].length });
+
+			size_t index = 0;
+			size_t bytes_written = 0;
+			while (index < iov.size()) {
+
+				ssize_t result = _append ?
+					AppendWriteV(_fd, &iov[index], iov.size() - index) :
+					PositionalWriteV(_fd, &iov[index], iov.size() - index, position + bytes_written);
+
+				if (result < 0) {
+					if (errno == EINTR)
+						continue;
+					ThrowLastError();
+				}
+
+				bytes_written += (size_t)result;
+				index = AdvanceIovecs(iov, index, (size_t)result);
+
+			}
+
+			return;
+
+		}
+#endif
+
+		// Otherwise, write each span in turn.
+		size_t bytes_written = 0;
+		for (size_t i = 0; i < count; ++i) {
+			WriteToFile(spans[i].data, spans[i].length, position + bytes_written, concurrent);
+			bytes_written += spans[i].length;
+		}
+
+	}
+	Byte* FileStream::DirectBuffer() {
+
+		if (!_direct_buffer)
+			_direct_buffer = (Byte*)AllocateAligned(DIRECT_BUFFER_SIZE, DIRECT_IO_ALIGNMENT);
+
+		return _direct_buffer;
+
+	}
+	size_t FileStream::DirectRead(void* buffer, size_t length, size_t position, Byte* staging_buffer) {
+
+		Byte* addr = (Byte*)buffer;
+		size_t end = position + length;
+		size_t bytes_read = 0;
+
+		while (bytes_read < length) {
+
+			// Read the aligned blocks covering the next part of the range into the staging buffer.
+			size_t pos = position + bytes_read;
+			size_t block_start = AlignDown(pos, DIRECT_IO_ALIGNMENT);
+			size_t block_end = (std::min)(AlignUp(end, DIRECT_IO_ALIGNMENT), block_start + DIRECT_BUFFER_SIZE);
+			size_t skip = pos - block_start;
+
+			size_t result = ReadFully(staging_buffer, block_end - block_start, block_start);
+
+			// If we didn't get past the start of the requested range, we've reached the end of the file.
+			if (result <= skip)
+				break;
+
+			// Copy the requested part of the blocks to the output buffer.
+			size_t count = (std::min)(result - skip, length - bytes_read);
+			memcpy(addr + bytes_read, staging_buffer + skip, count);
+			bytes_read += count;
+
+			if (result < block_end - block_start)
+				break;
+
+		}
+
+		return bytes_read;
+
+	}
+	void FileStream::DirectWrite(const void* buffer, size_t length, size_t position, Byte* staging_buffer) {
+
+		const Byte* addr = (const Byte*)buffer;
+		size_t end = position + length;
+		size_t bytes_written = 0;
+
+		while (bytes_written < length) {
+
+			// Find the aligned blocks covering the next part of the range.
+			size_t pos = position + bytes_written;
+			size_t block_start = AlignDown(pos, DIRECT_IO_ALIGNMENT);
+			size_t block_end = (std::min)(AlignUp(end, DIRECT_IO_ALIGNMENT), block_start + DIRECT_BUFFER_SIZE);
+			size_t block_length = block_end - block_start;
+			size_t skip = pos - block_start;
+			size_t count = (std::min)(length - bytes_written, block_length - skip);
+
+			// Only the first and last blocks can be partially overwritten. Fill them with their current contents (or zeros past the end of the file) first.
+			if (skip > 0) {
+				size_t result = ReadFully(staging_buffer, DIRECT_IO_ALIGNMENT, block_start);
+				memset(staging_buffer + result, 0, DIRECT_IO_ALIGNMENT - result);
+			}
+			if (skip + count < block_length && (skip == 0 || block_length > DIRECT_IO_ALIGNMENT)) {
+				size_t tail = block_length - DIRECT_IO_ALIGNMENT;
+				size_t result = ReadFully(staging_buffer + tail, DIRECT_IO_ALIGNMENT, block_start + tail);
+				memset(staging_buffer + tail + result, 0, DIRECT_IO_ALIGNMENT - result);
+			}
+
+			// Merge in the new data, and write the blocks back.
+			memcpy(staging_buffer + skip, addr + bytes_written, count);
+			WriteFully(staging_buffer, block_length, block_start);
+			bytes_written += count;
+
+		}
+
+		// Writing whole blocks may have padded the file past the end of the new data, so trim it back.
+		size_t length_after = (std::max)(_length.load(), end);
+		if (AlignUp(end, DIRECT_IO_ALIGNMENT) > length_after)
+			while (TruncateFile(_fd, length_after) < 0)
+				if (errno != EINTR)
+					ThrowLastError();
+
 	}
 
-}
\ No newline at end of file
+}
@@ -1,6 +1,7 @@
 #pragma once
 #include "IStream.h"
-#include <fstream>
+#include <atomic>
+#include <string>
 
 namespace IO {
 
@@ -30,7 +31,33 @@ namespace IO {
 		Write
 	};
 
-	// Provides a Stream for a file.
+	// Represents advanced options for creating a FileStream object.
+	enum class FileOptions {
+		// Indicates that no additional options should be used.
+		None,
+		// Indicates that reads and writes should bypass the operating system's page cache (O_DIRECT). Unaligned requests are staged through an aligned buffer.
+		Direct
+	};
+
+	// Specifies which parts of a file are made durable by FileStream::Sync.
+	enum class SyncMode {
+		// Writes the file's data, and only the metadata needed to read it back (such as its length), to the storage device (fdatasync).
+		Data,
+		// Writes the file's data and all of its metadata to the storage device (fsync).
+		Full
+	};
+
+	class FileHandleCache;
+
+	// Specifies how FileStream::CopyTo treats holes in sparse files.
+	enum class CopyMode {
+		// Copies every byte, so holes in the source are filled with zeros in the destination.
+		Dense,
+		// Copies only the regions of the source that contain data, and leaves holes in the destination where the source has them.
+		PreserveHoles
+	};
+
+	// Provides a Stream for a file. Reads and writes go directly to the file descriptor using positional I/O, so no data is buffered by the stream.
 	class FileStream : public IStream {
 
 	public:
@@ -38,6 +65,11 @@ namespace IO {
 		FileStream(const char* path, FileMode mode);
 		// Initializes a new instance of the FileStream class with the specified path, creation mode, and read/write permission.
 		FileStream(const char* path, FileMode mode, FileAccess access);
+		// Initializes a new instance of the FileStream class with the specified path, creation mode, read/write permission, and options.
+		FileStream(const char* path, FileMode mode, FileAccess access, FileOptions options);
+		// Initializes a new instance of the FileStream class that shares a cached descriptor for the file with other streams, instead of opening the file itself.
+		// The descriptor is returned to the cache when the stream is closed. FileMode::CreateNew and FileMode::Append need a descriptor of their own, so they bypass the cache.
+		FileStream(const char* path, FileMode mode, FileAccess access, FileHandleCache& cache);
 		// Releases all resources used by the Stream.
 		virtual ~FileStream();
 
@@ -45,10 +77,23 @@ namespace IO {
 		size_t Length() override;
 		// Gets the current position of this stream.
 		size_t Position() const override;
-		// Clears buffers for this stream and causes any buffered data to be written to the file.
+		// Gets the operating system file descriptor for the file that the stream encapsulates, or -1 if the stream is closed.
+		int Handle() const;
+		// Clears buffers for this stream and causes any buffered data to be written to the file. FileStream does not buffer data, so this does nothing. Use Sync to make written data durable.
 		virtual void Flush() override;
+		// Writes all data written to the file to the storage device, and waits for the device to report that it has been stored durably.
+		void Sync(SyncMode mode);
 		// Sets the length of this stream to the given value.
 		virtual void SetLength(size_t length) override;
+		// Allocates disk space for the first "length" bytes of the file, extending the file if it is shorter. Writes within the allocated range will not fail due to a lack of disk space.
+		void Preallocate(size_t length);
+		// Deallocates the disk space for the given range of the file, which reads as zeros afterwards. The length of the file is not changed.
+		// If the file system cannot deallocate the range, it is overwritten with zeros instead.
+		void PunchHole(size_t offset, size_t length);
+		// Sets the position to the start of the first region of data at or after the given offset, and returns the new position. If there is no more data, the position is set to the end of the file.
+		size_t SeekData(size_t offset);
+		// Sets the position to the start of the first hole at or after the given offset, and returns the new position. The end of the file counts as a hole.
+		size_t SeekHole(size_t offset);
 		// Reads a byte from the file and advances the read position one byte.
 		virtual bool ReadByte(Byte& byte) override;
 		// Writes a byte to the current position in the file stream.
@@ -57,8 +102,36 @@ namespace IO {
 		virtual size_t Read(void* buffer, size_t offset, size_t length) override;
 		// Writes a block of bytes to the file stream.
 		virtual void Write(const void* buffer, size_t offset, size_t length) override;
+		// Reads a block of bytes at the given position in the file, without using or changing the current position.
+		virtual size_t ReadAt(size_t position, void* buffer, size_t length) override;
+		// Writes a block of bytes at the given position in the file, without using or changing the current position.
+		virtual void WriteAt(size_t position, const void* buffer, size_t length) override;
+		// Writes a sequence of buffers at the given position in the file, without using or changing the current position.
+		void WriteVAt(size_t position, const ConstSpan* spans, size_t count);
+		// Copies the remaining bytes of the file to another stream. If the other stream is also a FileStream, the copy is performed by the kernel.
+		virtual void CopyTo(IStream& stream) override;
+		// Copies the remaining bytes of the file to another stream, using a specified buffer size if the copy cannot be performed by the kernel.
+		virtual void CopyTo(IStream& stream, size_t buffer_size) override;
+		// Copies the remaining bytes of the file to another file without passing the data through user space, using copy_file_range (which can share extents on filesystems that support reflinks), sendfile, or splice.
+		// Falls back to a buffered copy where none of these are available.
+		void CopyTo(FileStream& stream);
+		// Copies the remaining bytes of the file to another file as above, using a specified buffer size if the copy cannot be performed by the kernel.
+		void CopyTo(FileStream& stream, size_t buffer_size);
+		// Copies the remaining bytes of the file to another file as above. With CopyMode::PreserveHoles, only regions containing data are copied, so the time taken is proportional to the data rather than the length of the file.
+		void CopyTo(FileStream& stream, CopyMode mode);
+		using IStream::CopyTo;
+		// Copies the remaining bytes of the given file stream to this file stream, as with CopyTo.
+		virtual bool CopyFrom(FileStream& stream, size_t buffer_size) override;
+		// Reads a block of bytes from the stream into each of the given spans in turn, using a single vectored read where possible.
+		virtual size_t ReadV(const Span* spans, size_t count) override;
+		// Writes the contents of each of the given spans to the file stream, using a single vectored write where possible.
+		virtual void WriteV(const ConstSpan* spans, size_t count) override;
 		// Closes the current stream and releases any resources associated with the current stream.
 		virtual void Close() override;
+		// Advises the kernel how the given range of the file will be accessed, using posix_fadvise. Does nothing for direct I/O, which bypasses the page cache.
+		virtual void Advise(AccessPattern pattern, size_t offset, size_t length) override;
+		// Starts reading the given range of the file into the page cache in the background, using readahead. Does nothing for direct I/O.
+		virtual void Prefetch(size_t offset, size_t length) override;
 		// Sets the current position of this stream to the given value.
 		virtual size_t Seek(long long offset, SeekOrigin origin) override;
 		// Sets the current position of this stream to the given value.
@@ -69,26 +142,66 @@ namespace IO {
 		virtual bool CanSeek() const override;
 		// Gets a value indicating whether the current stream supports writing.
 		virtual bool CanWrite() const override;
+		// Gets a value indicating whether ReadAt and WriteAt can be called concurrently. These use pread/pwrite on POSIX platforms and ReadFile/WriteFile with an explicit offset on Windows, and take no locks.
+		// Unaligned direct writes that extend the file, or that share a block with another write, must still be serialized by the caller.
+		virtual bool CanAccessConcurrently() const override;
+
+		// The alignment required of positions, lengths, and buffer addresses for direct I/O to bypass the staging buffer.
+		static const size_t DIRECT_IO_ALIGNMENT = 4096;
 
 	protected:
-		// Returns true if a file with the given path exists.
-		bool FileExists(const char* path);
+		// Opens the file, through the given cache if it is not null, and reads its initial length.
+		void Open(const char* path, FileHandleCache* cache);
 		// Initializes mode/access flag values.
-		void InitFlags(FileMode mode, FileAccess access);
+		void InitFlags(FileMode mode, FileAccess access, FileOptions options);
+		// Reads up to "length" bytes at the given position in the file, without affecting the stream position. Returns the number of bytes read.
+		// If "concurrent" is true, a private staging buffer is used for direct I/O so that the call is safe to make from multiple threads.
+		size_t ReadFromFile(void* buffer, size_t length, size_t position, bool concurrent = false);
+		// Writes "length" bytes at the given position in the file (or the end of the file in "Append" mode), without affecting the stream position.
+		void WriteToFile(const void* buffer, size_t length, size_t position, bool concurrent = false);
+		// Increases the cached length of the file to "length" if it is shorter.
+		void ExtendLength(size_t length);
 
 	private:
-		// The underlying stream.
-		std::fstream _stream;
+		// The underlying file descriptor, or -1 if the stream is closed.
+		int _fd;
 		// The path to the file the stream is accessing.
 		std::string _path;
 		// The current position in the stream.
 		std::size_t _position;
-		// Mode flags.
-		unsigned int _flags;
-		// File access flags.
-		unsigned int _access_flags;
-		// Set to true if the last action was a read (as opposed to a write).
-		bool _last_read;
+		// The length of the file. Updated by writes made through this stream, so external changes to the file are not observed.
+		std::atomic<std::size_t> _length;
+		// Flags passed to open().
+		int _flags;
+		// The access requested when the stream was opened.
+		FileAccess _access;
+		// Set to true if the stream was opened in "Append" mode.
+		bool _append;
+		// The options the stream was opened with.
+		FileOptions _options;
+		// The aligned staging buffer used for unaligned direct I/O.
+		Byte* _direct_buffer;
+		// The cache the descriptor was acquired from, or null if the stream owns its descriptor.
+		FileHandleCache* _cache;
+
+		// Returns the offset of the first region of data (or hole) at or after the given offset, or the length of the file if there is none.
+		size_t FindData(size_t offset);
+		size_t FindHole(size_t offset);
+		// Copies "length" bytes from the current position to the other file's current position, within the kernel where possible, and advances both positions.
+		// Anything the kernel can't copy goes through a buffer of at most "buffer_size" bytes.
+		void CopyRange(FileStream& stream, size_t length, size_t buffer_size);
+		// Returns the stream's staging buffer for direct I/O, allocating it if necessary.
+		Byte* DirectBuffer();
+		// Reads from or writes to the file in full, retrying after interruptions and short transfers.
+		size_t ReadFully(void* buffer, size_t length, size_t position);
+		void WriteFully(const void* buffer, size_t length, size_t position);
+		// Performs vectored reads and writes in full, retrying after interruptions and short transfers.
+		size_t ReadVFully(const Span* spans, size_t count, size_t position);
+		void WriteVFully(const ConstSpan* spans, size_t count, size_t position, bool concurrent = false);
+		// Performs an unaligned direct read by reading whole aligned blocks into the staging buffer.
+		size_t DirectRead(void* buffer, size_t length, size_t position, Byte* staging_buffer);
+		// Performs an unaligned direct write by merging the data with the surrounding blocks in the staging buffer.
+		void DirectWrite(const void* buffer, size_t length, size_t position, Byte* staging_buffer);
 
 	};
 
@@ -0,0 +1,68 @@
+#include "GroupCommit.h"
+
+namespace IO {
+
+	GroupCommit::GroupCommit(FileStream& stream, SyncMode mode) {
+
+		// Initialize member variables.
+		_stream = &stream;
+		_mode = mode;
+		_requested = 0;
+		_completed = 0;
+		_syncing = false;
+		_sync_count = 0;
+
+	}
+
+	void GroupCommit::Commit() {
+
+		std::unique_lock<std::mutex> lock(_mutex);
+
+		// Take a ticket. Any sync that starts after this point covers the caller's writes.
+		uint64_t ticket = ++_requested;
+
+		while (_completed < ticket) {
+
+			if (_error)
+				std::rethrow_exception(_error);
+
+			// If a sync is already in progress, it may have started before the caller's writes, so wait for it and check again.
+			if (_syncing) {
+				_synced.wait(lock);
+				continue;
+			}
+
+			// Otherwise, sync on behalf of every writer that has taken a ticket so far.
+			uint64_t target = _requested;
+			_syncing = true;
+			lock.unlock();
+
+			try {
+				_stream->Sync(_mode);
+			}
+			catch (...) {
+				lock.lock();
+				_error = std::current_exception();
+				_syncing = false;
+				_synced.notify_all();
+				throw;
+			}
+
+			lock.lock();
+			_completed = target;
+			_syncing = false;
+			++_sync_count;
+			_synced.notify_all();
+
+		}
+
+	}
+	size_t GroupCommit::SyncCount() const {
+
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		return _sync_count;
+
+	}
+
+}
\ No newline at end of file
@@ -0,0 +1,50 @@
+#pragma once
+#include "FileStream.h"
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+
+namespace IO {
+
+	// Batches the durability barriers of many writers to the same file into shared syncs.
+	// Each writer calls Commit after its writes have completed. One caller performs the sync on behalf of every writer that committed before it started,
+	// while writers that commit during a sync wait and are made durable together by the next one.
+	class GroupCommit {
+
+	public:
+		// Initializes a new instance of the GroupCommit class that syncs the given file stream using the given mode.
+		GroupCommit(FileStream& stream, SyncMode mode);
+		GroupCommit(const GroupCommit& other) = delete;
+
+		// Blocks until all writes completed before the call are durable. If a sync fails, this and every later call throws,
+		// since the state of the data written before the failed sync is unknown.
+		void Commit();
+		// Gets the number of syncs performed.
+		size_t SyncCount() const;
+
+		GroupCommit& operator=(const GroupCommit& other) = delete;
+
+	private:
+		// The file being synced.
+		FileStream* _stream;
+		// The mode passed to FileStream::Sync.
+		SyncMode _mode;
+		// Protects the members below.
+		mutable std::mutex _mutex;
+		// Signalled when a sync completes.
+		std::condition_variable _synced;
+		// The ticket given to the most recent call to Commit.
+		uint64_t _requested;
+		// The highest ticket that has been made durable.
+		uint64_t _completed;
+		// True while a sync is in progress.
+		bool _syncing;
+		// The number of syncs performed.
+		size_t _sync_count;
+		// The exception thrown by a failed sync.
+		std::exception_ptr _error;
+
+	};
+
+}
\ No newline at end of file
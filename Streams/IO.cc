@@ -2,6 +2,16 @@
 #include "Exception.h"
 #include <cassert>
 #include <cmath>
+#include <cstdlib>
+#include <new>
+#ifdef _WIN32
+#include <malloc.h>
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
 #define BITS_PER_BYTE 8
 
 namespace IO {
@@ -69,4 +79,69 @@ namespace IO {
 
 	}
 
+	bool IsAligned(size_t value, size_t alignment) {
+
+		return (value & (alignment - 1)) == 0;
+
+	}
+	bool IsAligned(const void* address, size_t alignment) {
+
+		return IsAligned((size_t)(uintptr_t)address, alignment);
+
+	}
+	size_t AlignDown(size_t value, size_t alignment) {
+
+		return value & ~(alignment - 1);
+
+	}
+	size_t AlignUp(size_t value, size_t alignment) {
+
+		return AlignDown(value + alignment - 1, alignment);
+
+	}
+	void* AllocateAligned(size_t bytes, size_t alignment) {
+
+		// The alignment must be at least the alignment of a pointer for posix_memalign.
+		if (alignment < sizeof(void*))
+			alignment = sizeof(void*);
+
+#ifdef _WIN32
+		void* address = _aligned_malloc(bytes, alignment);
+#else
+		void* address = nullptr;
+		if (posix_memalign(&address, alignment, bytes) != 0)
+			address = nullptr;
+#endif
+
+		if (!address)
+			throw std::bad_alloc();
+
+		return address;
+
+	}
+	void FreeAligned(void* address) {
+
+#ifdef _WIN32
+		_aligned_free(address);
+#else
+		free(address);
+#endif
+
+	}
+	size_t PageSize() {
+
+#ifdef _WIN32
+		static const size_t page_size = [] {
+			SYSTEM_INFO info;
+			GetSystemInfo(&info);
+			return (size_t)info.dwPageSize;
+		}();
+#else
+		static const size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+#endif
+
+		return page_size;
+
+	}
+
 }
\ No newline at end of file
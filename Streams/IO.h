@@ -1,10 +1,27 @@
 #pragma once
 #include <stdint.h>
+#include <stddef.h>
 
 namespace IO {
 
 	typedef uint8_t Byte;
 
+	// Describes a contiguous region of writable memory.
+	struct Span {
+		// The address of the first byte in the region.
+		Byte* data;
+		// The number of bytes in the region.
+		size_t length;
+	};
+
+	// Describes a contiguous region of read-only memory.
+	struct ConstSpan {
+		// The address of the first byte in the region.
+		const Byte* data;
+		// The number of bytes in the region.
+		size_t length;
+	};
+
 	// Returns the number of bits corresponding to the given number of bytes.
 	int BytesToBits(size_t bytes);
 	// Returns the number of bytes corresponding to the given number of bits.
@@ -20,4 +37,19 @@ namespace IO {
 	// Sets the nth bit of the given byte to the given value, where 0 is the most-significant bit and 7 is the least-significant bit.
 	void SetBit(Byte& byte, Byte bit, bool value);
 
+	// Returns true if the given value is a multiple of the given alignment, which must be a power of two.
+	bool IsAligned(size_t value, size_t alignment);
+	// Returns true if the given address is a multiple of the given alignment, which must be a power of two.
+	bool IsAligned(const void* address, size_t alignment);
+	// Rounds the given value down to a multiple of the given alignment, which must be a power of two.
+	size_t AlignDown(size_t value, size_t alignment);
+	// Rounds the given value up to a multiple of the given alignment, which must be a power of two.
+	size_t AlignUp(size_t value, size_t alignment);
+	// Allocates a block of memory whose address is a multiple of the given alignment, which must be a power of two. The block must be freed with FreeAligned.
+	void* AllocateAligned(size_t bytes, size_t alignment);
+	// Frees a block of memory allocated with AllocateAligned.
+	void FreeAligned(void* address);
+	// Returns the size of a virtual memory page.
+	size_t PageSize();
+
 }
\ No newline at end of file
@@ -1,12 +1,16 @@
 #pragma once
 #include "IStream.h"
 #include "Exception.h"
+#include "BufferPool.h"
 #include <cassert>
 
 // The following definitions are defaults and should be overridden by the derived class to improve efficiency.
 
 namespace IO {
 
+	// Defined here because the constant is bound to references (such as by std::min), which requires a definition.
+	const size_t IStream::DEFAULT_COPY_BUFFER_SIZE;
+
 	size_t IStream::Read(void* buffer, size_t offset, size_t length) {
 		
 		if (!CanRead())
@@ -34,34 +38,103 @@ namespace IO {
 		for (size_t i = 0; i < length; ++i)
 			WriteByte(*(addr + i));
 
+	}
+	size_t IStream::ReadAt(size_t position, void* buffer, size_t length) {
+
+		if (!CanRead() || !CanSeek())
+			throw NotSupportedException();
+
+		// Seek to the given position, read, and then restore the previous position.
+		size_t previous_position = Position();
+		Seek((long long)position);
+		size_t bytes_read = Read(buffer, 0, length);
+		Seek((long long)previous_position);
+
+		return bytes_read;
+
+	}
+	void IStream::WriteAt(size_t position, const void* buffer, size_t length) {
+
+		if (!CanWrite() || !CanSeek())
+			throw NotSupportedException();
+
+		// Seek to the given position, write, and then restore the previous position.
+		size_t previous_position = Position();
+		Seek((long long)position);
+		Write(buffer, 0, length);
+		Seek((long long)previous_position);
+
+	}
+	size_t IStream::ReadV(const Span* spans, size_t count) {
+
+		size_t bytes_read = 0;
+		for (size_t i = 0; i < count; ++i) {
+
+			size_t result = Read(spans[i].data, 0, spans[i].length);
+			bytes_read += result;
+
+			// Stop if we've reached the end of the stream.
+			if (result < spans[i].length)
+				break;
+
+		}
+
+		return bytes_read;
+
+	}
+	void IStream::WriteV(const ConstSpan* spans, size_t count) {
+
+		for (size_t i = 0; i < count; ++i)
+			Write(spans[i].data, 0, spans[i].length);
+
 	}
 	void IStream::Close() {}
 	void IStream::CopyTo(IStream& stream) {
 		
-		if (!CanRead() || !stream.CanWrite())
-			throw NotSupportedException();
+		CopyTo(stream, DEFAULT_COPY_BUFFER_SIZE);
 
-		Byte byte;
-		while (ReadByte(byte))
-			stream.WriteByte(byte);
+	}
+	bool IStream::CopyFrom(FileStream& stream, size_t buffer_size) {
+
+		return false;
 
 	}
+	void IStream::Advise(AccessPattern pattern, size_t offset, size_t length) {}
+	void IStream::Prefetch(size_t offset, size_t length) {}
 	void IStream::CopyTo(IStream& stream, size_t buffer_size) {
 		
+		CopyTo(stream, buffer_size, BufferPool::Shared());
+
+	}
+	void IStream::CopyTo(IStream& stream, size_t buffer_size, BufferPool& pool) {
+
 		// Throw an exception of the stream is not readable, or the output stream is not writeable.
 		if (!CanRead() || !stream.CanWrite())
 			throw NotSupportedException();
 
-		// Create a buffer of the required size.
-		Byte* buf = new Byte[buffer_size];
+		// Rent a buffer of the required size.
+		Byte* buf = pool.Rent(buffer_size);
 
 		// Read/write until no more bytes can be read.
-		size_t bytes_read;
-		while (bytes_read = Read(buf, 0, buffer_size), bytes_read > 0) 
-			stream.Write(buf, 0, bytes_read);
+		try {
+			size_t bytes_read;
+			while (bytes_read = Read(buf, 0, buffer_size), bytes_read > 0)
+				stream.Write(buf, 0, bytes_read);
+		}
+		catch (...) {
+			pool.Return(buf, buffer_size);
+			throw;
+		}
+
+		// Return the buffer to the pool.
+		pool.Return(buf, buffer_size);
+
+	}
+
+	bool IStream::CanAccessConcurrently() const {
 
-		// Dispose of the buffer.
-		delete[] buf;
+		// The default ReadAt/WriteAt implementations move the stream position.
+		return false;
 
 	}
 
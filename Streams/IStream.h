@@ -15,6 +15,23 @@ namespace IO {
 		End
 	};
 
+	// Specifies how a range of a stream is expected to be accessed.
+	enum class AccessPattern {
+		// Specifies no particular pattern. This is the default.
+		Normal,
+		// Specifies that the range will be read sequentially, from lower to higher offsets.
+		Sequential,
+		// Specifies that the range will be read in a random order.
+		Random,
+		// Specifies that the range will be read in the near future.
+		WillNeed,
+		// Specifies that the range will not be read in the near future.
+		DontNeed
+	};
+
+	class BufferPool;
+	class FileStream;
+
 	class IStream {
 		
 	public:
@@ -34,12 +51,30 @@ namespace IO {
 		virtual size_t Read(void* buffer, size_t offset, size_t length);
 		// Writes a sequence of bytes to the current stream and advances the current position within this stream by the number of bytes written.
 		virtual void Write(const void* buffer, size_t offset, size_t length);
+		// Reads up to "length" bytes beginning at the given position in the stream, without using or changing the current position. Returns the number of bytes read.
+		virtual size_t ReadAt(size_t position, void* buffer, size_t length);
+		// Writes "length" bytes beginning at the given position in the stream, without using or changing the current position.
+		virtual void WriteAt(size_t position, const void* buffer, size_t length);
+		// Reads a sequence of bytes from the current stream into each of the given spans in turn, and advances the position within the stream by the number of bytes read.
+		virtual size_t ReadV(const Span* spans, size_t count);
+		// Writes the contents of each of the given spans in turn to the current stream, and advances the position within the stream by the number of bytes written.
+		virtual void WriteV(const ConstSpan* spans, size_t count);
 		// Closes the current stream and releases any resources (such as sockets and file handles) associated with the current stream.
 		virtual void Close();
 		// Reads the bytes from the current stream and writes them to another stream.
 		virtual void CopyTo(IStream& stream);
+		// Copies the remaining bytes of the given file stream to the current stream using a method specific to this type of stream, or returns false if there is none.
+		// Called by FileStream::CopyTo so that the copy can be specialized for both the source and destination types. The buffer size is used for any part of the copy that needs a buffer.
+		virtual bool CopyFrom(FileStream& stream, size_t buffer_size);
 		// Reads the bytes from the current stream and writes them to another stream, using a specified buffer size.
 		virtual void CopyTo(IStream& stream, size_t buffer_size);
+		// Reads the bytes from the current stream and writes them to another stream, using a buffer of the specified size rented from the given pool.
+		void CopyTo(IStream& stream, size_t buffer_size, BufferPool& pool);
+		// Advises the stream how the given range will be accessed, so that it can tune its caching and readahead. A length of zero extends the range to the end of the stream.
+		// This is only a hint, and does nothing by default.
+		virtual void Advise(AccessPattern pattern, size_t offset, size_t length);
+		// Starts loading the given range into the cache in the background, so that later reads of it do not block. Does nothing by default.
+		virtual void Prefetch(size_t offset, size_t length);
 		// When overridden in a derived class, sets the position within the current stream.
 		virtual size_t Seek(long long offset, SeekOrigin origin) = 0;
 		// When overridden in a derived class, sets the position within the current stream.
@@ -50,6 +85,11 @@ namespace IO {
 		virtual bool CanSeek() const = 0;
 		// When overridden in a derived class, gets a value indicating whether the current stream supports writing.
 		virtual bool CanWrite() const = 0;
+		// Gets a value indicating whether ReadAt and WriteAt can be called concurrently from multiple threads without external synchronization.
+		virtual bool CanAccessConcurrently() const;
+
+		// The buffer size used by CopyTo when none is specified.
+		static const size_t DEFAULT_COPY_BUFFER_SIZE = 81920;
 
 		// Writes a byte to the current position in the stream and advances the position within the stream by one byte.
 		virtual IStream& operator << (Byte byte);
@@ -0,0 +1,343 @@
+#include "MappedFileStream.h"
+#include "Exception.h"
+#ifndef _WIN32
+#include <cerrno>
+#include <cstring>
+#include <algorithm>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace IO {
+
+	namespace {
+
+		// Writable mappings need a descriptor opened for reading as well as writing.
+		FileAccess MappingAccess(FileAccess access) {
+
+			return access == FileAccess::Read ? FileAccess::Read : FileAccess::ReadWrite;
+
+		}
+		// Appending is emulated by positioning the stream at the end of the file, since the mapping can be written anywhere.
+		FileMode MappingMode(FileMode mode) {
+
+			return mode == FileMode::Append ? FileMode::OpenOrCreate : mode;
+
+		}
+
+	}
+
+	MappedFileStream::MappedFileStream(const char* path, FileMode mode) : MappedFileStream(path, mode, FileAccess::ReadWrite) {}
+	MappedFileStream::MappedFileStream(const char* path, FileMode mode, FileAccess access) :
+		_file(path, MappingMode(mode), MappingAccess(access)) {
+
+		// Initialize member variables.
+		_data = nullptr;
+		_capacity = 0;
+		_length = _file.Length();
+		_position = 0;
+		_can_read = access != FileAccess::Write && mode != FileMode::Append;
+		_can_write = access != FileAccess::Read;
+
+		// Map the current contents of the file.
+		if (_length > 0)
+			Map(_length);
+
+		// If opened in "Append" mode, start at the end of the file.
+		if (mode == FileMode::Append)
+			_position = _length;
+
+	}
+	MappedFileStream::~MappedFileStream() {
+
+		Close();
+
+	}
+
+	size_t MappedFileStream::Length() {
+
+		return _length;
+
+	}
+	size_t MappedFileStream::Position() const {
+
+		return _position;
+
+	}
+	Byte* MappedFileStream::Data() const {
+
+		return _data;
+
+	}
+	void MappedFileStream::Flush() {
+
+		if (_data && _can_write && msync(_data, _length, MS_SYNC) < 0)
+			throw IOException(std::strerror(errno));
+
+	}
+	void MappedFileStream::SetLength(size_t length) {
+
+		// Throw error if the stream does not support writing.
+		if (!CanWrite())
+			throw NotSupportedException();
+
+		// Grow the mapping if needed. The new region of the file reads as zeros.
+		if (length > _capacity)
+			Reserve(length);
+
+		// If the stream is being shortened, clear the truncated bytes so that they read as zeros if the stream is extended again.
+		else if (length < _length)
+			memset(_data + length, 0, _length - length);
+
+		// Set the new length.
+		_length = length;
+
+		// If the length is less than the seek position, move seek position to end.
+		if (_position > _length)
+			_position = _length;
+
+	}
+	bool MappedFileStream::ReadByte(Byte& byte) {
+
+		// Throw an exception of the stream is not readable.
+		if (!CanRead())
+			throw NotSupportedException();
+
+		// Return false if we're at the end of the stream.
+		if (_position >= _length)
+			return false;
+
+		byte = _data[_position++];
+
+		return true;
+
+	}
+	void MappedFileStream::WriteByte(Byte byte) {
+
+		Write(&byte, 0, 1);
+
+	}
+	size_t MappedFileStream::Read(void* buffer, size_t offset, size_t length) {
+
+		// Throw an exception of the stream is not readable.
+		if (!CanRead())
+			throw NotSupportedException();
+
+		// If the stream has been seeked beyond the end of the stream, there is nothing to read.
+		if (_position >= _length)
+			return 0;
+
+		// Copy the number of bytes remaining or the requested length-- Whichever is fewer.
+		size_t len = (std::min)(length, _length - _position);
+		memcpy((Byte*)buffer + offset * sizeof(Byte), _data + _position, len);
+		_position += len;
+
+		return len;
+
+	}
+	void MappedFileStream::Write(const void* buffer, size_t offset, size_t length) {
+
+		// Throw an exception of the stream is not writeable.
+		if (!CanWrite())
+			throw NotSupportedException();
+
+		if (length == 0)
+			return;
+
+		// Make enough room in the mapping for new data.
+		Reserve(_position + length);
+
+		// Copy memory from the input buffer to the mapping.
+		memcpy(_data + _position, (const Byte*)buffer + offset * sizeof(Byte), length);
+
+		// Move the seek position forward by the number of bytes written.
+		_position += length;
+
+		// If the stream is now longer, increase the length.
+		if (_position > _length)
+			_length = _position;
+
+	}
+	void MappedFileStream::Close() {
+
+		// Unmap the file, and trim any extra capacity allocated for growth.
+		if (_data) {
+			Unmap();
+			if (_can_write && _file.Length() != _length)
+				_file.SetLength(_length);
+		}
+
+		// Close the file.
+		_file.Close();
+
+		// Reset the seek position and flags.
+		_length = 0;
+		_position = 0;
+		_can_read = false;
+		_can_write = false;
+
+	}
+	void MappedFileStream::CopyTo(IStream& stream) {
+
+		// Throw an exception of the stream is not readable.
+		if (!CanRead())
+			throw NotSupportedException();
+
+		// If the seek position is greater than or equal to the length of the stream, do nothing.
+		if (_position >= _length)
+			return;
+
+		// Write remaining contents of the mapping directly to the other stream.
+		stream.Write(_data, _position, _length - _position);
+		_position = _length;
+
+	}
+	void MappedFileStream::CopyTo(IStream& stream, size_t buffer_size) {
+
+		CopyTo(stream);
+
+	}
+	void MappedFileStream::Advise(AccessPattern pattern, size_t offset, size_t length) {
+
+		// Only the mapped part of the file can be advised.
+		if (!_data || offset >= _capacity)
+			return;
+		if (length == 0 || length > _capacity - offset)
+			length = _capacity - offset;
+
+		int advice = MADV_NORMAL;
+		switch (pattern) {
+		case AccessPattern::Normal:
+			advice = MADV_NORMAL;
+			break;
+		case AccessPattern::Sequential:
+			advice = MADV_SEQUENTIAL;
+			break;
+		case AccessPattern::Random:
+			advice = MADV_RANDOM;
+			break;
+		case AccessPattern::WillNeed:
+			advice = MADV_WILLNEED;
+			break;
+		case AccessPattern::DontNeed:
+			advice = MADV_DONTNEED;
+			break;
+		}
+
+		// madvise requires a page-aligned address.
+		size_t start = offset / PageSize() * PageSize();
+		if (madvise(_data + start, length + (offset - start), advice) < 0)
+			throw IOException(std::strerror(errno));
+
+	}
+	void MappedFileStream::Prefetch(size_t offset, size_t length) {
+
+		Advise(AccessPattern::WillNeed, offset, length);
+
+	}
+	size_t MappedFileStream::Seek(long long offset, SeekOrigin origin) {
+
+		// Throw an exception of the stream is not seekable.
+		if (!CanSeek())
+			throw NotSupportedException();
+
+		// Get the origin position from the seek origin.
+		long long origin_position = 0;
+		switch (origin) {
+		case SeekOrigin::Current:
+			origin_position = (long long)_position;
+			break;
+		case SeekOrigin::End:
+			origin_position = (long long)_length;
+			break;
+		}
+
+		// Throw an error if the new position is less than 0.
+		if (origin_position + offset < 0)
+			throw IOException("An attempt was made to move the position before the beginning of the stream.");
+
+		// Apply the new position.
+		_position = (size_t)(origin_position + offset);
+
+		// Return the new position.
+		return _position;
+
+	}
+	size_t MappedFileStream::Seek(long long position) {
+
+		return Seek(position, SeekOrigin::Begin);
+
+	}
+	bool MappedFileStream::CanRead() const {
+
+		return _can_read;
+
+	}
+	bool MappedFileStream::CanSeek() const {
+
+		return _can_read || _can_write;
+
+	}
+	bool MappedFileStream::CanWrite() const {
+
+		return _can_write;
+
+	}
+
+	// Protected methods
+
+	void MappedFileStream::Map(size_t capacity) {
+
+		// Make sure the file is large enough to back the whole mapping. Accessing a mapped page beyond the end of the file raises SIGBUS.
+		if (_can_write && _file.Length() < capacity)
+			_file.SetLength(capacity);
+
+		int protection = PROT_READ | (_can_write ? PROT_WRITE : 0);
+		void* data;
+
+#ifdef __linux__
+		// On Linux, the existing mapping can be grown in place (or moved) by the kernel without remapping the pages.
+		if (_data)
+			data = mremap(_data, _capacity, capacity, MREMAP_MAYMOVE);
+		else
+#endif
+		{
+			// Map the new region before unmapping the old one, so that the old mapping survives a failure.
+			data = mmap(nullptr, capacity, protection, MAP_SHARED, _file.Handle(), 0);
+			if (data != MAP_FAILED)
+				Unmap();
+		}
+
+		// If remapping failed, the previous mapping is left intact.
+		if (data == MAP_FAILED)
+			throw IOException(std::strerror(errno));
+
+		_data = (Byte*)data;
+		_capacity = capacity;
+
+	}
+	void MappedFileStream::Unmap() {
+
+		if (_data)
+			munmap(_data, _capacity);
+
+		_data = nullptr;
+		_capacity = 0;
+
+	}
+	void MappedFileStream::Reserve(size_t bytes) {
+
+		// If the mapping is already large enough, do nothing.
+		if (bytes <= _capacity)
+			return;
+
+		// Grow the mapping geometrically (rounded up to a whole number of pages) so that sequential writes are amortized.
+		size_t capacity = (std::max)(bytes, _capacity * 2);
+		capacity = (capacity + PageSize() - 1) / PageSize() * PageSize();
+
+		Map(capacity);
+
+	}
+
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,85 @@
+#pragma once
+#include "IStream.h"
+#include "FileStream.h"
+
+namespace IO {
+
+	// Provides a Stream for a memory-mapped file. Reads and writes are performed directly on the mapping, without system calls or intermediate copies.
+	// Available on POSIX platforms only.
+	class MappedFileStream : public IStream {
+
+	public:
+		// Initializes a new instance of the MappedFileStream class with the specified path and creation mode.
+		MappedFileStream(const char* path, FileMode mode);
+		// Initializes a new instance of the MappedFileStream class with the specified path, creation mode, and read/write permission.
+		MappedFileStream(const char* path, FileMode mode, FileAccess access);
+		// Releases all resources used by the Stream.
+		virtual ~MappedFileStream();
+
+		// Gets the length in bytes of the stream.
+		virtual size_t Length() override;
+		// Gets the current position of this stream.
+		virtual size_t Position() const override;
+		// Returns the address of the mapped contents of the file, or null if nothing is mapped. The address is invalidated when the stream grows or is closed.
+		Byte* Data() const;
+		// Writes modified pages of the mapping to the file, and waits for the writes to complete.
+		virtual void Flush() override;
+		// Sets the length of this stream to the given value.
+		virtual void SetLength(size_t length) override;
+		// Reads a byte from the mapping and advances the read position one byte.
+		virtual bool ReadByte(Byte& byte) override;
+		// Writes a byte to the current position in the mapping.
+		virtual void WriteByte(Byte byte) override;
+		// Copies a block of bytes from the mapping to the given buffer.
+		virtual size_t Read(void* buffer, size_t offset, size_t length) override;
+		// Copies a block of bytes from the given buffer to the mapping.
+		virtual void Write(const void* buffer, size_t offset, size_t length) override;
+		// Unmaps the file, trims any space reserved for growth, and closes the file.
+		virtual void Close() override;
+		// Writes the remaining contents of the mapping to another stream.
+		virtual void CopyTo(IStream& stream) override;
+		// Writes the remaining contents of the mapping to another stream. The buffer size is ignored, since no intermediate buffer is needed.
+		virtual void CopyTo(IStream& stream, size_t buffer_size) override;
+		using IStream::CopyTo;
+		// Advises the kernel how the given range of the mapping will be accessed, using madvise.
+		virtual void Advise(AccessPattern pattern, size_t offset, size_t length) override;
+		// Asks the kernel to start paging in the given range of the mapping.
+		virtual void Prefetch(size_t offset, size_t length) override;
+		// Sets the current position of this stream to the given value.
+		virtual size_t Seek(long long offset, SeekOrigin origin) override;
+		// Sets the current position of this stream to the given value.
+		virtual size_t Seek(long long position) override;
+		// Gets a value indicating whether the current stream supports reading.
+		virtual bool CanRead() const override;
+		// Gets a value indicating whether the current stream supports seeking.
+		virtual bool CanSeek() const override;
+		// Gets a value indicating whether the current stream supports writing.
+		virtual bool CanWrite() const override;
+
+	protected:
+		// Maps (or remaps) the first "capacity" bytes of the file, extending the file if necessary.
+		void Map(size_t capacity);
+		// Unmaps the file.
+		void Unmap();
+		// Grows the mapping (if necessary) to be able to contain "bytes" bytes.
+		void Reserve(size_t bytes);
+
+	private:
+		// The underlying file.
+		FileStream _file;
+		// The address of the mapping.
+		Byte* _data;
+		// The number of bytes mapped. This may be larger than the length of the stream, in which case the file is trimmed when it is closed.
+		size_t _capacity;
+		// The length of the stream.
+		size_t _length;
+		// The current position in the stream.
+		size_t _position;
+		// True if the stream supports reading.
+		bool _can_read;
+		// True if the stream supports writing.
+		bool _can_write;
+
+	};
+
+}
\ No newline at end of file
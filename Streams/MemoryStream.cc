@@ -8,25 +8,69 @@
 
 namespace IO {
 
+	namespace {
+
+		// The smallest capacity allocated when an expandable stream first grows.
+		const size_t MIN_GROWTH_CAPACITY = 64;
+		// Shortening the stream to less than 1/SHRINK_FACTOR of its capacity releases the excess capacity.
+		const size_t SHRINK_FACTOR = 4;
+
+	}
+
 	// Public methods
 
 	MemoryStream::MemoryStream() : MemoryStream(0) {}
-	MemoryStream::MemoryStream(size_t capacity) {
+	MemoryStream::MemoryStream(size_t capacity) : MemoryStream(capacity, Allocator::Default()) {}
+	MemoryStream::MemoryStream(Allocator& allocator) : MemoryStream(0, allocator) {}
+	MemoryStream::MemoryStream(size_t capacity, Allocator& allocator) {
 
+		_allocator = &allocator;
 		_length = 0;
 		_capacity = capacity;
-		_buffer = (Byte*)malloc(capacity);
+		_buffer = (Byte*)_allocator->Allocate(capacity);
 		_position = 0;
 		_owns_buffer = true;
+		_inline_buffer = nullptr;
+		_inline_capacity = 0;
 
 	}
 	MemoryStream::MemoryStream(Byte* buffer, size_t size) {
 
+		_allocator = &Allocator::Default();
 		_length = size;
 		_capacity = size;
 		_buffer = buffer;
 		_position = 0;
 		_owns_buffer = false;
+		_inline_buffer = nullptr;
+		_inline_capacity = 0;
+
+	}
+	MemoryStream::MemoryStream(Byte* buffer, size_t length, size_t capacity, bool owns_buffer) {
+
+		if (length > capacity)
+			throw ArgumentException("length must be less than or equal to capacity");
+
+		_allocator = &Allocator::Default();
+		_length = length;
+		_capacity = capacity;
+		_buffer = buffer;
+		_position = 0;
+		_owns_buffer = owns_buffer;
+		_inline_buffer = nullptr;
+		_inline_capacity = 0;
+
+	}
+	MemoryStream::MemoryStream(Byte* inline_buffer, size_t inline_capacity, Allocator& allocator) {
+
+		_allocator = &allocator;
+		_length = 0;
+		_capacity = inline_capacity;
+		_buffer = inline_buffer;
+		_position = 0;
+		_owns_buffer = true;
+		_inline_buffer = inline_buffer;
+		_inline_capacity = inline_capacity;
 
 	}
 	MemoryStream::~MemoryStream() {
@@ -49,6 +93,54 @@ namespace IO {
 
 		return _position;
 
+	}
+	ConstSpan MemoryStream::GetSpan() const {
+
+		// A closed stream no longer has any contents to expose.
+		if (!_buffer)
+			return ConstSpan{ nullptr, 0 };
+
+		return ConstSpan{ _buffer, _length };
+
+	}
+	bool MemoryStream::TryGetBuffer(Span& buffer) {
+
+		if (!_buffer)
+			return false;
+
+		buffer = Span{ _buffer, _length };
+
+		return true;
+
+	}
+	Byte* MemoryStream::Detach(size_t& length, size_t& capacity) {
+
+		// If we don't own the buffer, it isn't ours to give away.
+		if (!_owns_buffer)
+			throw NotSupportedException("Memory stream does not own its buffer.");
+
+		// Inline storage can't outlive the stream, so its contents are moved to the heap first.
+		if (IsInline())
+			MoveToHeap(_capacity);
+
+		Byte* buffer = _buffer;
+		length = _length;
+		capacity = _capacity;
+
+		// Start over with an empty buffer of our own, or with the inline storage if there is any.
+		if (_inline_buffer) {
+			_buffer = _inline_buffer;
+			_capacity = _inline_capacity;
+		}
+		else {
+			_buffer = (Byte*)_allocator->Allocate(0);
+			_capacity = 0;
+		}
+		_length = 0;
+		_position = 0;
+
+		return buffer;
+
 	}
 	bool MemoryStream::IsEmpty() const {
 
@@ -66,9 +158,23 @@ namespace IO {
 		if (length > _capacity)
 			Reserve(length);
 
+		// If the stream is being extended, clear the new bytes, which may hold stale or uninitialized data.
+		if (length > _length)
+			memset(_buffer + _length * sizeof(Byte), 0, length - _length);
+
 		// Set the new length.
 		_length = length;
 
+		// If the stream has shrunk well below its capacity, give the excess back if the allocator would return it to the system. Other allocators keep the capacity for reuse.
+		// The margin keeps a stream that shrinks and grows again from reallocating every time.
+		if (_owns_buffer && !IsInline() && length < _capacity / SHRINK_FACTOR) {
+			size_t capacity = (std::max)(length, MIN_GROWTH_CAPACITY);
+			if (capacity < _capacity && _allocator->ShouldTrim(_capacity, capacity)) {
+				_buffer = (Byte*)_allocator->Reallocate(_buffer, _capacity, capacity);
+				_capacity = capacity;
+			}
+		}
+
 		// If the length is less than the seek position, move seek position to end.
 		if (_position > _length)
 			_position = _length;
@@ -102,6 +208,7 @@ namespace IO {
 
 		// Make enough room in the buffer for new data.
 		AllocateBytes(sizeof(Byte));
+		ZeroGap(_position);
 
 		// Copy the data to the buffer.
 		memcpy(_buffer + _position * sizeof(Byte), &byte, sizeof(Byte));
@@ -134,7 +241,7 @@ namespace IO {
 			return 0;
 
 		// Copy memory from the buffer to the output buffer.
-		memcpy((Byte*)buffer + offset * sizeof(Byte), _buffer + _position * sizeof(Byte), length);
+		memcpy((Byte*)buffer + offset * sizeof(Byte), _buffer + _position * sizeof(Byte), len);
 
 		// Increase the seek position by bytes read.
 		_position += len;
@@ -151,6 +258,7 @@ namespace IO {
 
 		// Make enough room in the buffer for new data.
 		AllocateBytes(length);
+		ZeroGap(_position);
 
 		// Copy memory from the input buffer to the internal buffer.
 		memcpy(_buffer + _position * sizeof(Byte), (Byte*)buffer + offset * sizeof(Byte), length);
@@ -162,11 +270,88 @@ namespace IO {
 		if (_position > _length)
 			_length = _position;
 
+	}
+	size_t MemoryStream::ReadAt(size_t position, void* buffer, size_t length) {
+
+		// Throw an exception of the stream is not readable.
+		if (!CanRead())
+			throw NotSupportedException();
+
+		// There is nothing to read beyond the end of the stream.
+		if (position >= _length)
+			return 0;
+
+		size_t len = (std::min)(length, _length - position);
+		memcpy(buffer, _buffer + position * sizeof(Byte), len);
+
+		return len;
+
+	}
+	void MemoryStream::WriteAt(size_t position, const void* buffer, size_t length) {
+
+		// Throw an exception of the stream is not writeable.
+		if (!CanWrite())
+			throw NotSupportedException();
+
+		// Make enough room in the buffer for new data.
+		ExpandCapacity(position + length);
+		ZeroGap(position);
+
+		memcpy(_buffer + position * sizeof(Byte), buffer, length);
+
+		// If the stream is now longer, increase the length.
+		if (position + length > _length)
+			_length = position + length;
+
+	}
+	size_t MemoryStream::ReadV(const Span* spans, size_t count) {
+
+		// Throw an exception of the stream is not readable.
+		if (!CanRead())
+			throw NotSupportedException();
+
+		size_t bytes_read = 0;
+		for (size_t i = 0; i < count && _position < _length; ++i) {
+
+			// Copy as much of the span as there is data left in the stream.
+			size_t len = (std::min)(spans[i].length, _length - _position);
+			memcpy(spans[i].data, _buffer + _position * sizeof(Byte), len);
+			_position += len;
+			bytes_read += len;
+
+		}
+
+		return bytes_read;
+
+	}
+	void MemoryStream::WriteV(const ConstSpan* spans, size_t count) {
+
+		// Throw an exception of the stream is not writeable.
+		if (!CanWrite())
+			throw NotSupportedException();
+
+		// Make enough room in the buffer for all of the spans up front.
+		size_t length = 0;
+		for (size_t i = 0; i < count; ++i)
+			length += spans[i].length;
+		AllocateBytes(length);
+		ZeroGap(_position);
+
+		// Copy each span into the internal buffer.
+		for (size_t i = 0; i < count; ++i) {
+			memcpy(_buffer + _position * sizeof(Byte), spans[i].data, spans[i].length);
+			_position += spans[i].length;
+		}
+
+		// If the stream is now longer, increase the length.
+		if (_position > _length)
+			_length = _position;
+
 	}
 	void MemoryStream::Close() {
 
-		if (_buffer && _owns_buffer)
-			free(_buffer);
+		if (_buffer && _owns_buffer && !IsInline())
+			_allocator->Deallocate(_buffer, _capacity);
 		_buffer = nullptr;
 
 	}
@@ -187,7 +372,8 @@ namespace IO {
 	}
 	void MemoryStream::CopyTo(IStream& stream, size_t buffer_size) {
 
-		IStream::CopyTo(stream, buffer_size);
+		// No intermediate buffer is needed, since the contents are already in memory.
+		CopyTo(stream);
 
 	}
 	size_t MemoryStream::Seek(long long offset, SeekOrigin origin) {
@@ -240,6 +426,11 @@ namespace IO {
 
 		return _buffer != nullptr;
 
+	}
+	bool MemoryStream::CanAccessConcurrently() const {
+
+		return _buffer != nullptr;
+
 	}
 
 	// Protected methods
@@ -247,16 +438,27 @@ namespace IO {
 	void MemoryStream::AllocateBytes(size_t bytes) {
 
 		// Calculate the required capacity. Note that the position may be greater than the length.
-		size_t required_capacity = _position + bytes;
+		ExpandCapacity(_position + bytes);
+
+	}
+	void MemoryStream::ExpandCapacity(size_t capacity) {
 
 		// Increase buffer capacity if needed.
-		if (required_capacity > _capacity) {
-			size_t new_capacity = _capacity > 0 ? _capacity : 1;
-			while (required_capacity > new_capacity)
+		if (capacity > _capacity) {
+			// Small streams start from a minimum capacity, so that writing them a few bytes at a time doesn't reallocate repeatedly.
+			size_t new_capacity = (std::max)(_capacity, MIN_GROWTH_CAPACITY);
+			while (capacity > new_capacity)
 				new_capacity *= 2;
 			Reserve(new_capacity);
 		}
 
+	}
+	void MemoryStream::ZeroGap(size_t position) {
+
+		// If the stream has been seeked beyond the end, the bytes between the end and the write position must read as zeros.
+		if (position > _length)
+			memset(_buffer + _length * sizeof(Byte), 0, position - _length);
+
 	}
 	Byte* MemoryStream::Buffer() {
 
@@ -273,9 +475,12 @@ namespace IO {
 		if (_capacity >= capacity)
 			return;
 
-		// Increase the capacity of the buffer and clear the new memory.
-		_buffer = (Byte*)realloc(_buffer, capacity);
-		memset(_buffer + _capacity, 0, capacity - _capacity);
+		// Increase the capacity of the buffer. The new memory is left uninitialized, since it is usually written immediately. Gaps that are never written are cleared by ZeroGap.
+		// Once the inline storage has been outgrown, the contents spill to the heap.
+		if (IsInline())
+			MoveToHeap(capacity);
+		else
+			_buffer = (Byte*)_allocator->Reallocate(_buffer, _capacity, capacity);
 
 		_capacity = capacity;
 
@@ -286,21 +491,41 @@ namespace IO {
 		if (!_owns_buffer)
 			throw NotSupportedException("Memory stream is not expandable.");
 
-		// Adjust the size of the buffer.
-		_buffer = (Byte*)realloc(_buffer, size);
+		// Adjust the size of the buffer. Inline storage is kept for as long as it's large enough, and is never truncated.
+		if (!IsInline()) {
+			_buffer = (Byte*)_allocator->Reallocate(_buffer, _capacity, size);
+			_capacity = size;
+		}
+		else if (size > _capacity) {
+			MoveToHeap(size);
+			_capacity = size;
+		}
 
 		// If the buffer is larger, fill new memory with given value.
 		if (size > _length)
 			memset(_buffer + _length * sizeof(Byte), value, size - _length);
 
-		// Update size and capcity counters.
-		_capacity = size;
+		// Update size counter.
 		_length = size;
 
 		// If the seek position is now beyond the end of the buffer, move it to the end of the buffer.
 		if (_position > _length)
 			_position = _length;
 
+	}
+	bool MemoryStream::IsInline() const {
+
+		return _inline_buffer != nullptr && _buffer == _inline_buffer;
+
+	}
+
+	// Private methods
+
+	void MemoryStream::MoveToHeap(size_t capacity) {
+
+		Byte* buffer = (Byte*)_allocator->Allocate(capacity);
+		memcpy(buffer, _buffer, (std::min)(_length, capacity));
+		_buffer = buffer;
 
 	}
 
@@ -1,5 +1,6 @@
 #pragma once
 #include "IStream.h"
+#include "Allocator.h"
 
 namespace IO {
 
@@ -10,8 +11,15 @@ namespace IO {
 		MemoryStream();
 		// Initializes a new instance of the MemoryStream class with an expandable capacity initialized as specified.
 		MemoryStream(size_t capacity);
+		// Initializes a new instance of the MemoryStream class with an expandable capacity initialized to zero, whose buffer is allocated with the given allocator.
+		MemoryStream(Allocator& allocator);
+		// Initializes a new instance of the MemoryStream class with an expandable capacity initialized as specified, whose buffer is allocated with the given allocator.
+		MemoryStream(size_t capacity, Allocator& allocator);
 		// Initializes a new non-resizable instance of the MemoryStream class based on the specified byte array.
 		MemoryStream(Byte* buffer, size_t size);
+		// Initializes a new instance of the MemoryStream class based on the specified byte array, whose first "length" bytes are the contents of the stream.
+		// If "owns_buffer" is true, the stream takes over the lifetime of the buffer, which must have been allocated with malloc, and can expand it. Otherwise, the stream can write up to "capacity" bytes.
+		MemoryStream(Byte* buffer, size_t length, size_t capacity, bool owns_buffer);
 		// Releases all resources used by the Stream.
 		virtual ~MemoryStream();
 
@@ -21,11 +29,19 @@ namespace IO {
 		virtual size_t Capacity() const;
 		// Gets the current position within the stream.
 		virtual size_t Position() const override;
+		// Returns the contents of the stream without copying them, or an empty span if the stream is closed. The span is invalidated when the stream is written to or closed.
+		ConstSpan GetSpan() const;
+		// Gets the contents of the stream without copying them, or returns false if the stream is closed. The span is invalidated when the stream grows or is closed.
+		bool TryGetBuffer(Span& buffer);
+		// Transfers ownership of the underlying buffer to the caller, and leaves the stream empty. Returns the buffer, and stores the length of its contents in "length" and its size in "capacity".
+		// The caller must free the buffer with free() if the stream uses the default allocator, and otherwise with the stream's allocator, passing "capacity" as the size.
+		// Throws NotSupportedException if the stream does not own its buffer.
+		Byte* Detach(size_t& length, size_t& capacity);
 		// Returns true if the stream is empty.
 		virtual bool IsEmpty() const;
 		// Clears contents of the Stream.
 		virtual void Flush() override;
-		// Sets the length of the current stream to the specified value.
+		// Sets the length of the current stream to the specified value. If the stream is shortened to a small fraction of its capacity and its allocator returns memory to the system on shrinking (such as PageAllocator), the excess capacity is released.
 		virtual void SetLength(size_t length) override;
 		// Reads a byte from the stream and advances the position within the stream by one byte, or returns false if at the end of the stream.
 		virtual bool ReadByte(Byte& byte) override;
@@ -35,12 +51,21 @@ namespace IO {
 		virtual size_t Read(void* buffer, size_t offset, size_t length) override;
 		// Writes a block of bytes to the current stream using data read from a buffer.
 		virtual void Write(const void* buffer, size_t offset, size_t length) override;
+		// Reads a block of bytes beginning at the given position in the stream, without using or changing the current position.
+		virtual size_t ReadAt(size_t position, void* buffer, size_t length) override;
+		// Writes a block of bytes beginning at the given position in the stream, without using or changing the current position.
+		virtual void WriteAt(size_t position, const void* buffer, size_t length) override;
+		// Reads a block of bytes from the current stream into each of the given spans in turn.
+		virtual size_t ReadV(const Span* spans, size_t count) override;
+		// Writes the contents of each of the given spans to the current stream, expanding the buffer at most once.
+		virtual void WriteV(const ConstSpan* spans, size_t count) override;
 		// Closes the current stream and releases any resources (such as sockets and file handles) associated with the current stream.
 		virtual void Close() override;
 		// Reads the bytes from the current stream and writes them to another stream.
 		virtual void CopyTo(IStream& stream) override;
-		// Reads the bytes from the current stream and writes them to another stream, using a specified buffer size.
+		// Reads the bytes from the current stream and writes them to another stream. The buffer size is ignored, since the contents are written directly from memory.
 		virtual void CopyTo(IStream& stream, size_t buffer_size) override;
+		using IStream::CopyTo;
 		// Sets the position within the current stream to the specified value.
 		virtual size_t Seek(long long offset, SeekOrigin origin) override;
 		// Sets the position within the current stream to the specified value.
@@ -51,23 +76,41 @@ namespace IO {
 		virtual bool CanSeek() const override;
 		// Gets a value indicating whether the current stream supports writing.
 		virtual bool CanWrite() const override;
+		// Gets a value indicating whether ReadAt and WriteAt can be called concurrently. Concurrent writes must not overlap or extend the stream, since growing the buffer moves it.
+		virtual bool CanAccessConcurrently() const override;
 
 	protected:
+		// Initializes a new instance of the MemoryStream class that stores its contents in the given inline storage (owned by a derived class), until it outgrows it and spills to the heap.
+		MemoryStream(Byte* inline_buffer, size_t inline_capacity, Allocator& allocator);
+
 		// Expands the buffer (if necessary) to be able to contain "bytes" additional bytes.
 		virtual void AllocateBytes(size_t bytes);
+		// Expands the buffer (if necessary) to be able to contain "capacity" bytes in total, growing it geometrically.
+		void ExpandCapacity(size_t capacity);
 		// Returns the underlying Byte buffer.
 		virtual Byte* Buffer();
-		// Resizes the underlying Byte buffer. If the given capacity is less than the current capacity, the buffer size is not modified.
+		// Clears the bytes between the end of the stream and the given position, which were never written.
+		void ZeroGap(size_t position);
+		// Resizes the underlying Byte buffer without initializing the new memory. If the given capacity is less than the current capacity, the buffer size is not modified.
 		virtual void Reserve(size_t capacity);
 		// Resizes the underlying Byte buffer, and fills new memory with the given value. If the given capacity is less than the current capacity, the buffer is truncated.
 		virtual void Resize(size_t size, Byte value = 0);
+		// Returns true if the contents of the stream are currently held in inline storage.
+		bool IsInline() const;
 
 	private:
+		// Copies the contents of the stream to a new heap buffer of the given capacity. The caller updates the capacity.
+		void MoveToHeap(size_t capacity);
+
+		Allocator* _allocator;
 		bool _owns_buffer;
 		Byte* _buffer;
 		size_t _length;
 		size_t _capacity;
 		size_t _position;
+		// Inline storage provided by a derived class, or null if there is none.
+		Byte* _inline_buffer;
+		size_t _inline_capacity;
 
 	};
 
@@ -0,0 +1,228 @@
+#include "MemoryStreamView.h"
+#include "Exception.h"
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+
+namespace IO {
+
+	// Public methods
+
+	MemoryStreamView::MemoryStreamView(const void* buffer, size_t length) :
+		_block(std::make_shared<MemoryStream>(length)) {
+
+		_block->Write(buffer, 0, length);
+		_position = 0;
+
+	}
+	MemoryStreamView::MemoryStreamView(MemoryStream& stream) : MemoryStreamView(stream.GetSpan().data, stream.GetSpan().length) {}
+	MemoryStreamView::MemoryStreamView(const MemoryStreamView& other) :
+		_block(other._block),
+		_position(other._position) {}
+	MemoryStreamView::~MemoryStreamView() {
+
+		Close();
+
+	}
+
+	size_t MemoryStreamView::Length() {
+
+		return _block ? _block->Length() : 0;
+
+	}
+	size_t MemoryStreamView::Position() const {
+
+		return _position;
+
+	}
+	ConstSpan MemoryStreamView::GetSpan() const {
+
+		if (!_block)
+			return ConstSpan{ nullptr, 0 };
+
+		return _block->GetSpan();
+
+	}
+	bool MemoryStreamView::IsShared() const {
+
+		return _block && _block.use_count() > 1;
+
+	}
+	void MemoryStreamView::Flush() {}
+	void MemoryStreamView::SetLength(size_t length) {
+
+		// Throw error if the stream does not support writing.
+		if (!CanWrite())
+			throw NotSupportedException();
+
+		Unshare();
+		_block->SetLength(length);
+
+		// If the length is less than the seek position, move seek position to end.
+		if (_position > length)
+			_position = length;
+
+	}
+	bool MemoryStreamView::ReadByte(Byte& byte) {
+
+		// Throw an exception of the stream is not readable.
+		if (!CanRead())
+			throw NotSupportedException();
+
+		ConstSpan span = _block->GetSpan();
+
+		// Return false if we're at the end of the stream.
+		if (_position >= span.length)
+			return false;
+
+		byte = span.data[_position++];
+
+		return true;
+
+	}
+	void MemoryStreamView::WriteByte(Byte byte) {
+
+		Write(&byte, 0, 1);
+
+	}
+	size_t MemoryStreamView::Read(void* buffer, size_t offset, size_t length) {
+
+		// Throw an exception of the stream is not readable.
+		if (!CanRead())
+			throw NotSupportedException();
+
+		ConstSpan span = _block->GetSpan();
+
+		// If the stream has been seeked beyond the end of the stream, there is nothing to read.
+		if (_position >= span.length)
+			return 0;
+
+		// Copy the number of bytes remaining or the requested length-- Whichever is fewer.
+		size_t len = (std::min)(length, span.length - _position);
+		memcpy((Byte*)buffer + offset * sizeof(Byte), span.data + _position, len);
+		_position += len;
+
+		return len;
+
+	}
+	void MemoryStreamView::Write(const void* buffer, size_t offset, size_t length) {
+
+		// Throw an exception of the stream is not writeable.
+		if (!CanWrite())
+			throw NotSupportedException();
+
+		if (length == 0)
+			return;
+
+		// Other views must keep seeing the contents they were created with.
+		Unshare();
+		_block->WriteAt(_position, (const Byte*)buffer + offset * sizeof(Byte), length);
+		_position += length;
+
+	}
+	void MemoryStreamView::Close() {
+
+		_block.reset();
+		_position = 0;
+
+	}
+	void MemoryStreamView::CopyTo(IStream& stream) {
+
+		// Throw an exception of the stream is not readable.
+		if (!CanRead())
+			throw NotSupportedException();
+
+		ConstSpan span = _block->GetSpan();
+
+		// If the seek position is greater than or equal to the length of the stream, do nothing.
+		if (_position >= span.length)
+			return;
+
+		// Write remaining contents of the block directly to the other stream.
+		stream.Write(span.data, _position, span.length - _position);
+		_position = span.length;
+
+	}
+	void MemoryStreamView::CopyTo(IStream& stream, size_t buffer_size) {
+
+		CopyTo(stream);
+
+	}
+	size_t MemoryStreamView::Seek(long long offset, SeekOrigin origin) {
+
+		// Throw an exception of the stream is not seekable.
+		if (!CanSeek())
+			throw NotSupportedException();
+
+		// Get the origin position from the seek origin.
+		long long origin_position = 0;
+		switch (origin) {
+		case SeekOrigin::Current:
+			origin_position = (long long)_position;
+			break;
+		case SeekOrigin::End:
+			origin_position = (long long)_block->Length();
+			break;
+		}
+
+		// Throw an error if the new position is less than 0.
+		if (origin_position + offset < 0)
+			throw IOException("An attempt was made to move the position before the beginning of the stream.");
+
+		// Apply the new position.
+		_position = (size_t)(origin_position + offset);
+
+		// Return the new position.
+		return _position;
+
+	}
+	size_t MemoryStreamView::Seek(long long position) {
+
+		return Seek(position, SeekOrigin::Begin);
+
+	}
+	bool MemoryStreamView::CanRead() const {
+
+		return _block != nullptr;
+
+	}
+	bool MemoryStreamView::CanSeek() const {
+
+		return _block != nullptr;
+
+	}
+	bool MemoryStreamView::CanWrite() const {
+
+		return _block != nullptr;
+
+	}
+	MemoryStreamView& MemoryStreamView::operator=(const MemoryStreamView& other) {
+
+		_block = other._block;
+		_position = other._position;
+
+		return *this;
+
+	}
+
+	// Protected methods
+
+	void MemoryStreamView::Unshare() {
+
+		// If no other view holds a reference, nobody else can observe the block, and it can be modified in place.
+		// (Another view can only be created from this one, so the count can't increase behind our back.)
+		// The fence pairs with the release decrement made when another view let go of the block, so its reads finish before we write.
+		if (_block.use_count() <= 1) {
+			std::atomic_thread_fence(std::memory_order_acquire);
+			return;
+		}
+
+		ConstSpan span = _block->GetSpan();
+		std::shared_ptr<MemoryStream> block = std::make_shared<MemoryStream>(span.length);
+		block->Write(span.data, 0, span.length);
+
+		_block = block;
+
+	}
+
+}
\ No newline at end of file
@@ -0,0 +1,76 @@
+#pragma once
+#include "IStream.h"
+#include "MemoryStream.h"
+#include <memory>
+
+namespace IO {
+
+	// Provides a Stream over a reference-counted block of memory that can be shared by any number of views, each with its own position.
+	// Copying a view is cheap: the copy shares the block instead of duplicating it. Views only read from the shared block, so views on different threads can read it without synchronization.
+	// Writing to a view that shares its block first gives the view a private copy of the block (copy-on-write). A single view is not safe to use from several threads at once.
+	class MemoryStreamView : public IStream {
+
+	public:
+		// Initializes a new instance of the MemoryStreamView class over a new block holding a copy of the given bytes.
+		MemoryStreamView(const void* buffer, size_t length);
+		// Initializes a new instance of the MemoryStreamView class over a new block holding a copy of the contents of the given stream.
+		MemoryStreamView(MemoryStream& stream);
+		// Initializes a new instance of the MemoryStreamView class that shares the block of another view, beginning at the same position.
+		MemoryStreamView(const MemoryStreamView& other);
+		// Releases this view's reference to the block. The block is freed when its last view is released.
+		virtual ~MemoryStreamView();
+
+		// Gets the length of the stream in bytes.
+		virtual size_t Length() override;
+		// Gets the current position within the stream.
+		virtual size_t Position() const override;
+		// Returns the contents of the block without copying them, or an empty span if the view is closed. The span is invalidated when the view is written to or closed.
+		ConstSpan GetSpan() const;
+		// Returns true if the block is shared with at least one other view.
+		bool IsShared() const;
+		// Does nothing, since the stream is not buffered.
+		virtual void Flush() override;
+		// Sets the length of the current stream to the specified value, copying the block first if it is shared.
+		virtual void SetLength(size_t length) override;
+		// Reads a byte from the stream and advances the position within the stream by one byte, or returns false if at the end of the stream.
+		virtual bool ReadByte(Byte& byte) override;
+		// Writes a byte to the current stream at the current position, copying the block first if it is shared.
+		virtual void WriteByte(Byte byte) override;
+		// Reads a block of bytes from the current stream and writes the data to a buffer.
+		virtual size_t Read(void* buffer, size_t offset, size_t length) override;
+		// Writes a block of bytes to the current stream using data read from a buffer, copying the block first if it is shared.
+		virtual void Write(const void* buffer, size_t offset, size_t length) override;
+		// Releases this view's reference to the block, and closes the view.
+		virtual void Close() override;
+		// Writes the remaining contents of the stream to another stream directly from the block.
+		virtual void CopyTo(IStream& stream) override;
+		// Writes the remaining contents of the stream to another stream. The buffer size is ignored, since no intermediate buffer is needed.
+		virtual void CopyTo(IStream& stream, size_t buffer_size) override;
+		using IStream::CopyTo;
+		// Sets the position within the current stream to the specified value.
+		virtual size_t Seek(long long offset, SeekOrigin origin) override;
+		// Sets the position within the current stream to the specified value.
+		virtual size_t Seek(long long position) override;
+		// Gets a value indicating whether the current stream supports reading.
+		virtual bool CanRead() const override;
+		// Gets a value indicating whether the current stream supports seeking.
+		virtual bool CanSeek() const override;
+		// Gets a value indicating whether the current stream supports writing.
+		virtual bool CanWrite() const override;
+
+		// Makes this view share the block of another view, beginning at the same position.
+		MemoryStreamView& operator=(const MemoryStreamView& other);
+
+	protected:
+		// Gives this view a private copy of its block if the block is shared with any other view.
+		void Unshare();
+
+	private:
+		// The block shared by all views created from the same contents.
+		std::shared_ptr<MemoryStream> _block;
+		// The position of this view within the block.
+		size_t _position;
+
+	};
+
+}
\ No newline at end of file
@@ -0,0 +1,168 @@
+#include "PageAllocator.h"
+#include "IO.h"
+#ifndef _WIN32
+#include <cstring>
+#include <algorithm>
+#include <new>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace IO {
+
+	namespace {
+
+		// The threshold used by default. Blocks smaller than a huge page gain nothing from being mapped.
+		const size_t DEFAULT_PAGE_THRESHOLD = 2 * 1024 * 1024;
+		// The size of a huge page. Mapped blocks are rounded up to a multiple of it when huge pages are used, so that the whole block can be backed by them.
+		const size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+		// Marks the given mapping as eligible for transparent huge pages, if the system supports them.
+		void AdviseHugePages(void* address, size_t size) {
+
+#ifdef MADV_HUGEPAGE
+			// The advice is only a hint, so failure is not an error.
+			madvise(address, size, MADV_HUGEPAGE);
+#endif
+
+		}
+
+	}
+
+	// Public methods
+
+	PageAllocator::PageAllocator() : PageAllocator(DEFAULT_PAGE_THRESHOLD) {}
+	PageAllocator::PageAllocator(size_t threshold, HugePageMode mode) : PageAllocator(threshold, mode, Allocator::Default()) {}
+	PageAllocator::PageAllocator(size_t threshold, HugePageMode mode, Allocator& fallback) {
+
+		_threshold = threshold;
+		_mode = mode;
+		_fallback = &fallback;
+		_bytes_mapped = 0;
+
+	}
+
+	void* PageAllocator::Allocate(size_t bytes) {
+
+		if (!IsMapped(bytes))
+			return _fallback->Allocate(bytes);
+
+		return Map(MappedSize(bytes));
+
+	}
+	void* PageAllocator::Reallocate(void* address, size_t old_bytes, size_t new_bytes) {
+
+		if (!address)
+			return Allocate(new_bytes);
+
+		// Small blocks stay with the fallback allocator.
+		if (!IsMapped(old_bytes) && !IsMapped(new_bytes))
+			return _fallback->Reallocate(address, old_bytes, new_bytes);
+
+		// Blocks crossing the threshold are moved between the fallback allocator and a mapping.
+		if (!IsMapped(old_bytes) || !IsMapped(new_bytes))
+			return Allocator::Reallocate(address, old_bytes, new_bytes);
+
+		size_t old_size = MappedSize(old_bytes);
+		size_t new_size = MappedSize(new_bytes);
+
+		if (new_size == old_size)
+			return address;
+
+#ifdef __linux__
+		// Let the kernel grow, shrink or move the mapping by rearranging page tables, without copying the contents.
+		// Shrinking the mapping returns the pages beyond the new size to the system.
+		void* new_address = mremap(address, old_size, new_size, MREMAP_MAYMOVE);
+		if (new_address != MAP_FAILED) {
+			_bytes_mapped += new_size;
+			_bytes_mapped -= old_size;
+			return new_address;
+		}
+#endif
+
+		// If the mapping can't be remapped (such as a huge page mapping on older kernels), copy it to a new one.
+		return Allocator::Reallocate(address, old_bytes, new_bytes);
+
+	}
+	void PageAllocator::Deallocate(void* address, size_t bytes) {
+
+		if (!address)
+			return;
+
+		if (!IsMapped(bytes)) {
+			_fallback->Deallocate(address, bytes);
+			return;
+		}
+
+		size_t size = MappedSize(bytes);
+		munmap(address, size);
+		_bytes_mapped -= size;
+
+	}
+	bool PageAllocator::ShouldTrim(size_t old_bytes, size_t new_bytes) const {
+
+		if (!IsMapped(old_bytes))
+			return false;
+
+		return !IsMapped(new_bytes) || MappedSize(new_bytes) < MappedSize(old_bytes);
+
+	}
+	size_t PageAllocator::Threshold() const {
+
+		return _threshold;
+
+	}
+	size_t PageAllocator::BytesMapped() const {
+
+		return _bytes_mapped;
+
+	}
+
+	PageAllocator& PageAllocator::Shared() {
+
+		static PageAllocator allocator;
+		return allocator;
+
+	}
+
+	// Private methods
+
+	bool PageAllocator::IsMapped(size_t bytes) const {
+
+		return bytes > 0 && bytes >= _threshold;
+
+	}
+	size_t PageAllocator::MappedSize(size_t bytes) const {
+
+		return AlignUp(bytes, _mode == HugePageMode::None ? PageSize() : HUGE_PAGE_SIZE);
+
+	}
+	void* PageAllocator::Map(size_t size) {
+
+		void* address = MAP_FAILED;
+
+#ifdef MAP_HUGETLB
+		// Explicit huge pages come from a pool the administrator has to reserve, so fall back to regular pages if it is empty.
+		if (_mode == HugePageMode::Explicit)
+			address = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif
+
+		if (address == MAP_FAILED) {
+
+			address = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+			if (address == MAP_FAILED)
+				throw std::bad_alloc();
+
+			if (_mode != HugePageMode::None)
+				AdviseHugePages(address, size);
+
+		}
+
+		_bytes_mapped += size;
+
+		return address;
+
+	}
+
+}
+
+#endif
\ No newline at end of file
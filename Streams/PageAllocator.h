@@ -0,0 +1,65 @@
+#pragma once
+#include "Allocator.h"
+#include <atomic>
+
+namespace IO {
+
+	// Defines how a PageAllocator uses huge pages for the blocks it maps.
+	enum class HugePageMode {
+		// Use regular pages only.
+		None,
+		// Ask the kernel to back the blocks with transparent huge pages where it can (madvise with MADV_HUGEPAGE).
+		Transparent,
+		// Map the blocks from the reserved huge page pool (MAP_HUGETLB), falling back to transparent huge pages if the pool is exhausted.
+		Explicit
+	};
+
+	// Provides an allocator that maps large blocks directly from the operating system with anonymous mmap, and forwards small ones to another allocator.
+	// Mapped blocks can be backed by huge pages to reduce TLB misses, are grown with mremap (on Linux) instead of being copied, and are returned to the system as soon as they are deallocated.
+	// Suited to large, long-lived buffers such as in-memory indexes. Available on POSIX platforms only.
+	class PageAllocator : public Allocator {
+
+	public:
+		// Initializes a new instance of the PageAllocator class with the default threshold, using transparent huge pages.
+		PageAllocator();
+		// Initializes a new instance of the PageAllocator class that maps blocks of at least "threshold" bytes, and allocates smaller blocks from the default allocator.
+		PageAllocator(size_t threshold, HugePageMode mode = HugePageMode::Transparent);
+		// Initializes a new instance of the PageAllocator class that maps blocks of at least "threshold" bytes, and allocates smaller blocks from the given allocator.
+		PageAllocator(size_t threshold, HugePageMode mode, Allocator& fallback);
+
+		// Maps a new block if "bytes" is at least the threshold, and otherwise allocates it from the fallback allocator.
+		virtual void* Allocate(size_t bytes) override;
+		// Resizes a mapped block with mremap where possible. Blocks crossing the threshold are moved between the mapping and the fallback allocator.
+		virtual void* Reallocate(void* address, size_t old_bytes, size_t new_bytes) override;
+		// Unmaps a mapped block, returning its memory to the system, or deallocates a small block with the fallback allocator.
+		virtual void Deallocate(void* address, size_t bytes) override;
+		// Returns true if the block is mapped, and shrinking it would unmap some of its pages.
+		virtual bool ShouldTrim(size_t old_bytes, size_t new_bytes) const override;
+		// Gets the size beyond which blocks are mapped.
+		size_t Threshold() const;
+		// Gets the number of bytes currently mapped by this allocator.
+		size_t BytesMapped() const;
+
+		// Returns a process-wide PageAllocator with the default threshold.
+		static PageAllocator& Shared();
+
+	private:
+		// Returns true if a block of the given size is mapped rather than allocated from the fallback allocator.
+		bool IsMapped(size_t bytes) const;
+		// Rounds the given size up to the granularity in which blocks are mapped.
+		size_t MappedSize(size_t bytes) const;
+		// Maps a new block of "size" bytes, which must be a multiple of the mapping granularity.
+		void* Map(size_t size);
+
+		// The size beyond which blocks are mapped.
+		size_t _threshold;
+		// How huge pages are used for mapped blocks.
+		HugePageMode _mode;
+		// The allocator for blocks below the threshold.
+		Allocator* _fallback;
+		// The number of bytes currently mapped.
+		std::atomic<size_t> _bytes_mapped;
+
+	};
+
+}
\ No newline at end of file
@@ -0,0 +1,286 @@
+#include "SegmentedMemoryStream.h"
+#include "BufferPool.h"
+#include "Exception.h"
+#include <cstring>
+#include <algorithm>
+
+namespace IO {
+
+	namespace {
+
+		// The segment size used by default.
+		const size_t DEFAULT_SEGMENT_SIZE = 64 * 1024;
+
+	}
+
+	// Public methods
+
+	SegmentedMemoryStream::SegmentedMemoryStream() : SegmentedMemoryStream(DEFAULT_SEGMENT_SIZE) {}
+	SegmentedMemoryStream::SegmentedMemoryStream(size_t segment_size) : SegmentedMemoryStream(segment_size, BufferPool::Shared()) {}
+	SegmentedMemoryStream::SegmentedMemoryStream(size_t segment_size, BufferPool& pool) {
+
+		if (segment_size == 0)
+			throw ArgumentException("segment size must be greater than 0");
+
+		_pool = &pool;
+		_segment_size = segment_size;
+		_length = 0;
+		_position = 0;
+		_open = true;
+
+	}
+	SegmentedMemoryStream::~SegmentedMemoryStream() {
+
+		Close();
+
+	}
+
+	size_t SegmentedMemoryStream::Length() {
+
+		return _length;
+
+	}
+	size_t SegmentedMemoryStream::Capacity() const {
+
+		return _segments.size() * _segment_size;
+
+	}
+	size_t SegmentedMemoryStream::Position() const {
+
+		return _position;
+
+	}
+	size_t SegmentedMemoryStream::SegmentSize() const {
+
+		return _segment_size;
+
+	}
+	size_t SegmentedMemoryStream::SegmentCount() const {
+
+		return (_length + _segment_size - 1) / _segment_size;
+
+	}
+	ConstSpan SegmentedMemoryStream::Segment(size_t index) const {
+
+		if (index >= SegmentCount())
+			throw ArgumentException("index is out of range");
+
+		return GetSpan(index * _segment_size);
+
+	}
+	ConstSpan SegmentedMemoryStream::GetSpan(size_t position) const {
+
+		if (position >= _length)
+			return ConstSpan{ nullptr, 0 };
+
+		size_t offset = position % _segment_size;
+		size_t length = (std::min)(_segment_size - offset, _length - position);
+
+		return ConstSpan{ _segments[position / _segment_size] + offset, length };
+
+	}
+	void SegmentedMemoryStream::Flush() {}
+	void SegmentedMemoryStream::SetLength(size_t length) {
+
+		// Throw error if the stream does not support writing.
+		if (!CanWrite())
+			throw NotSupportedException();
+
+		// Bytes past the old length were never written, so clear them if the stream is being extended.
+		if (length > _length) {
+			Reserve(length);
+			Zero(_length, length - _length);
+		}
+		else
+			Trim(length);
+
+		_length = length;
+
+		// If the length is less than the seek position, move seek position to end.
+		if (_position > _length)
+			_position = _length;
+
+	}
+	bool SegmentedMemoryStream::ReadByte(Byte& byte) {
+
+		// Throw an exception of the stream is not readable.
+		if (!CanRead())
+			throw NotSupportedException();
+
+		// Return false if we're at the end of the stream.
+		if (_position >= _length)
+			return false;
+
+		byte = _segments[_position / _segment_size][_position % _segment_size];
+		++_position;
+
+		return true;
+
+	}
+	void SegmentedMemoryStream::WriteByte(Byte byte) {
+
+		Write(&byte, 0, 1);
+
+	}
+	size_t SegmentedMemoryStream::Read(void* buffer, size_t offset, size_t length) {
+
+		// Throw an exception of the stream is not readable.
+		if (!CanRead())
+			throw NotSupportedException();
+
+		Byte* output = (Byte*)buffer + offset * sizeof(Byte);
+		size_t bytes_read = 0;
+
+		// Copy from each segment in turn until the request is satisfied or the end of the stream is reached.
+		while (bytes_read < length) {
+			ConstSpan span = GetSpan(_position);
+			if (span.length == 0)
+				break;
+			size_t count = (std::min)(span.length, length - bytes_read);
+			memcpy(output + bytes_read, span.data, count);
+			bytes_read += count;
+			_position += count;
+		}
+
+		return bytes_read;
+
+	}
+	void SegmentedMemoryStream::Write(const void* buffer, size_t offset, size_t length) {
+
+		// Throw an exception of the stream is not writeable.
+		if (!CanWrite())
+			throw NotSupportedException();
+
+		if (length == 0)
+			return;
+
+		// Add segments if needed. Existing segments are never moved.
+		Reserve(_position + length);
+
+		// If the stream has been seeked beyond the end, clear the gap.
+		if (_position > _length)
+			Zero(_length, _position - _length);
+
+		// Copy into each segment in turn.
+		const Byte* input = (const Byte*)buffer + offset * sizeof(Byte);
+		size_t bytes_written = 0;
+		while (bytes_written < length) {
+			size_t segment_offset = _position % _segment_size;
+			size_t count = (std::min)(_segment_size - segment_offset, length - bytes_written);
+			memcpy(_segments[_position / _segment_size] + segment_offset, input + bytes_written, count);
+			bytes_written += count;
+			_position += count;
+		}
+
+		// If the stream is now longer, increase the length.
+		if (_position > _length)
+			_length = _position;
+
+	}
+	void SegmentedMemoryStream::Close() {
+
+		Trim(0);
+
+		_length = 0;
+		_position = 0;
+		_open = false;
+
+	}
+	void SegmentedMemoryStream::CopyTo(IStream& stream) {
+
+		// Throw an exception of the stream is not readable.
+		if (!CanRead())
+			throw NotSupportedException();
+
+		// Write each remaining span directly to the other stream.
+		while (_position < _length) {
+			ConstSpan span = GetSpan(_position);
+			stream.Write(span.data, 0, span.length);
+			_position += span.length;
+		}
+
+	}
+	void SegmentedMemoryStream::CopyTo(IStream& stream, size_t buffer_size) {
+
+		CopyTo(stream);
+
+	}
+	size_t SegmentedMemoryStream::Seek(long long offset, SeekOrigin origin) {
+
+		// Throw an exception of the stream is not seekable.
+		if (!CanSeek())
+			throw NotSupportedException();
+
+		// Get the origin position from the seek origin.
+		long long origin_position = 0;
+		switch (origin) {
+		case SeekOrigin::Current:
+			origin_position = (long long)_position;
+			break;
+		case SeekOrigin::End:
+			origin_position = (long long)_length;
+			break;
+		}
+
+		// Throw an error if the new position is less than 0.
+		if (origin_position + offset < 0)
+			throw IOException("An attempt was made to move the position before the beginning of the stream.");
+
+		// Apply the new position.
+		_position = (size_t)(origin_position + offset);
+
+		// Return the new position.
+		return _position;
+
+	}
+	size_t SegmentedMemoryStream::Seek(long long position) {
+
+		return Seek(position, SeekOrigin::Begin);
+
+	}
+	bool SegmentedMemoryStream::CanRead() const {
+
+		return _open;
+
+	}
+	bool SegmentedMemoryStream::CanSeek() const {
+
+		return _open;
+
+	}
+	bool SegmentedMemoryStream::CanWrite() const {
+
+		return _open;
+
+	}
+
+	// Protected methods
+
+	void SegmentedMemoryStream::Reserve(size_t capacity) {
+
+		while (Capacity() < capacity)
+			_segments.push_back(_pool->Rent(_segment_size));
+
+	}
+	void SegmentedMemoryStream::Trim(size_t capacity) {
+
+		size_t segment_count = (capacity + _segment_size - 1) / _segment_size;
+		while (_segments.size() > segment_count) {
+			_pool->Return(_segments.back(), _segment_size);
+			_segments.pop_back();
+		}
+
+	}
+	void SegmentedMemoryStream::Zero(size_t position, size_t length) {
+
+		size_t end = position + length;
+		while (position < end) {
+			size_t offset = position % _segment_size;
+			size_t count = (std::min)(_segment_size - offset, end - position);
+			memset(_segments[position / _segment_size] + offset, 0, count);
+			position += count;
+		}
+
+	}
+
+}
\ No newline at end of file
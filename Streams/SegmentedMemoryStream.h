@@ -0,0 +1,93 @@
+#pragma once
+#include "IStream.h"
+#include <vector>
+
+namespace IO {
+
+	// Provides a Stream whose backing store is a list of fixed-size segments rented from a buffer pool, rather than one contiguous buffer.
+	// Growing the stream adds segments without moving any existing data, so appending is O(1) amortized and peak memory use stays close to the length of the stream.
+	// Readers that can work with non-contiguous data can access the segments directly through GetSpan and Segment.
+	class SegmentedMemoryStream : public IStream {
+
+	public:
+		// Initializes a new instance of the SegmentedMemoryStream class with the default segment size.
+		SegmentedMemoryStream();
+		// Initializes a new instance of the SegmentedMemoryStream class with the given segment size.
+		SegmentedMemoryStream(size_t segment_size);
+		// Initializes a new instance of the SegmentedMemoryStream class with the given segment size, renting segments from the given pool.
+		SegmentedMemoryStream(size_t segment_size, BufferPool& pool);
+		SegmentedMemoryStream(const SegmentedMemoryStream& other) = delete;
+		// Releases all resources used by the Stream.
+		virtual ~SegmentedMemoryStream();
+
+		// Gets the length of the stream in bytes.
+		virtual size_t Length() override;
+		// Gets the number of bytes allocated for this stream.
+		size_t Capacity() const;
+		// Gets the current position within the stream.
+		virtual size_t Position() const override;
+		// Gets the size of each segment in bytes.
+		size_t SegmentSize() const;
+		// Gets the number of segments containing data.
+		size_t SegmentCount() const;
+		// Returns the contents of the segment with the given index. The span is shorter than the segment size if it is the last segment.
+		ConstSpan Segment(size_t index) const;
+		// Returns the longest contiguous span of the stream's contents beginning at the given position, or an empty span if the position is at or beyond the end of the stream.
+		ConstSpan GetSpan(size_t position) const;
+		// Does nothing, since the stream is not buffered.
+		virtual void Flush() override;
+		// Sets the length of the current stream to the specified value. Segments beyond the new length are returned to the pool.
+		virtual void SetLength(size_t length) override;
+		// Reads a byte from the stream and advances the position within the stream by one byte, or returns false if at the end of the stream.
+		virtual bool ReadByte(Byte& byte) override;
+		// Writes a byte to the current stream at the current position.
+		virtual void WriteByte(Byte byte) override;
+		// Reads a block of bytes from the current stream and writes the data to a buffer.
+		virtual size_t Read(void* buffer, size_t offset, size_t length) override;
+		// Writes a block of bytes to the current stream using data read from a buffer.
+		virtual void Write(const void* buffer, size_t offset, size_t length) override;
+		// Returns all segments to the pool, and closes the stream.
+		virtual void Close() override;
+		// Writes the remaining contents of the stream to another stream directly from the segments.
+		virtual void CopyTo(IStream& stream) override;
+		// Writes the remaining contents of the stream to another stream. The buffer size is ignored, since no intermediate buffer is needed.
+		virtual void CopyTo(IStream& stream, size_t buffer_size) override;
+		using IStream::CopyTo;
+		// Sets the position within the current stream to the specified value.
+		virtual size_t Seek(long long offset, SeekOrigin origin) override;
+		// Sets the position within the current stream to the specified value.
+		virtual size_t Seek(long long position) override;
+		// Gets a value indicating whether the current stream supports reading.
+		virtual bool CanRead() const override;
+		// Gets a value indicating whether the current stream supports seeking.
+		virtual bool CanSeek() const override;
+		// Gets a value indicating whether the current stream supports writing.
+		virtual bool CanWrite() const override;
+
+		SegmentedMemoryStream& operator=(const SegmentedMemoryStream& other) = delete;
+
+	protected:
+		// Adds segments (if necessary) so that the stream can contain "capacity" bytes in total.
+		void Reserve(size_t capacity);
+		// Returns segments (if any) that are not needed to contain "capacity" bytes to the pool.
+		void Trim(size_t capacity);
+		// Fills the given range with zeros. Segments are not cleared when they are rented, so this is used for gaps left by seeking past the end or extending the stream.
+		void Zero(size_t position, size_t length);
+
+	private:
+		// The pool segments are rented from.
+		BufferPool* _pool;
+		// The segments, in order.
+		std::vector<Byte*> _segments;
+		// The size of each segment in bytes.
+		size_t _segment_size;
+		// The length of the stream.
+		size_t _length;
+		// The current position within the stream.
+		size_t _position;
+		// True until the stream is closed.
+		bool _open;
+
+	};
+
+}
\ No newline at end of file
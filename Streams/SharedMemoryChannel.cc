@@ -0,0 +1,206 @@
+#include "SharedMemoryChannel.h"
+#include "Exception.h"
+#ifndef _WIN32
+#include <chrono>
+#include <cstring>
+#include <algorithm>
+
+namespace IO {
+
+	// The counters shared by both sides of the channel. Each side's fields are on their own cache line, so that the two sides don't contend for it.
+	struct SharedMemoryChannel::Control {
+		// The total number of bytes sent. Only written by the sender.
+		alignas(64) std::atomic<uint64_t> head;
+		// Incremented every time bytes are sent, so that the receiver can wait on it.
+		std::atomic<uint32_t> head_sequence;
+		// Nonzero while the receiver is waiting for bytes.
+		std::atomic<uint32_t> receiver_waiting;
+		// The total number of bytes received. Only written by the receiver.
+		alignas(64) std::atomic<uint64_t> tail;
+		// Incremented every time bytes are received, so that the sender can wait on it.
+		std::atomic<uint32_t> tail_sequence;
+		// Nonzero while the sender is waiting for room.
+		std::atomic<uint32_t> sender_waiting;
+	};
+
+	namespace {
+
+		// Returns the given ring capacity, or throws IOException if a ring of that size could never hold any bytes.
+		size_t RingCapacity(size_t capacity) {
+
+			if (capacity == 0)
+				throw IOException("The capacity of a SharedMemoryChannel must be greater than zero.");
+
+			return capacity;
+
+		}
+		// Returns the number of milliseconds left until "deadline", or -1 (to wait indefinitely) if the timeout is negative.
+		int RemainingMilliseconds(std::chrono::steady_clock::time_point deadline, int timeout_milliseconds) {
+
+			if (timeout_milliseconds < 0)
+				return -1;
+
+			long long remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+
+			return remaining > 0 ? (int)remaining : 0;
+
+		}
+		// Waits until "ready" returns true, sleeping on "sequence" (which the other side increments after making progress) in between.
+		// "waiting" tells the other side that it needs to wake us. Returns false if the timeout expired first.
+		template <typename Ready>
+		bool Await(std::atomic<uint32_t>& sequence, std::atomic<uint32_t>& waiting, Ready ready, int timeout_milliseconds) {
+
+			if (ready())
+				return true;
+
+			auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_milliseconds);
+
+			for (;;) {
+
+				// Announce that we're waiting before checking again, so that the other side either sees the announcement or we see its progress.
+				waiting.store(1);
+				uint32_t expected = sequence.load();
+				if (ready())
+					break;
+
+				int remaining = -1;
+				if (timeout_milliseconds >= 0) {
+					remaining = (int)std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+					if (remaining <= 0)
+						break;
+				}
+
+				SharedMemoryStream::Wait(sequence, expected, remaining);
+
+			}
+
+			waiting.store(0);
+
+			return ready();
+
+		}
+
+	}
+
+	// Public methods
+
+	SharedMemoryChannel::SharedMemoryChannel(const char* name, size_t capacity) :
+		_memory(name, sizeof(Control) + RingCapacity(capacity)) {
+
+		// The counters start at zero, which the new object already reads as. Constructing them here would race with a process that has already opened it.
+		_control = (Control*)_memory.Data();
+		_ring = _memory.Data() + sizeof(Control);
+		_capacity = capacity;
+
+	}
+	SharedMemoryChannel::SharedMemoryChannel(const char* name) :
+		_memory(name) {
+
+		if (_memory.Capacity() <= sizeof(Control))
+			throw IOException("The shared memory object is not a SharedMemoryChannel.");
+
+		_control = (Control*)_memory.Data();
+		_ring = _memory.Data() + sizeof(Control);
+		_capacity = _memory.Capacity() - sizeof(Control);
+
+	}
+	SharedMemoryChannel::~SharedMemoryChannel() {
+
+		Close();
+
+	}
+
+	size_t SharedMemoryChannel::Capacity() const {
+
+		return _capacity;
+
+	}
+	size_t SharedMemoryChannel::Available() const {
+
+		if (!_control)
+			return 0;
+
+		return (size_t)(_control->head.load() - _control->tail.load());
+
+	}
+	size_t SharedMemoryChannel::Send(const void* buffer, size_t length, int timeout_milliseconds) {
+
+		if (!_control)
+			throw NotSupportedException();
+
+		const Byte* input = (const Byte*)buffer;
+		uint64_t head = _control->head.load(std::memory_order_relaxed);
+		size_t sent = 0;
+
+		// The timeout covers the whole call, however many times we have to wait for room.
+		auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds((std::max)(timeout_milliseconds, 0));
+
+		while (sent < length) {
+
+			// Wait for the receiver to make room.
+			auto has_room = [&] { return head - _control->tail.load() < _capacity; };
+			if (!Await(_control->tail_sequence, _control->sender_waiting, has_room, RemainingMilliseconds(deadline, timeout_milliseconds)))
+				break;
+
+			// Copy as much as fits into the ring, wrapping around the end.
+			size_t room = _capacity - (size_t)(head - _control->tail.load());
+			size_t count = (std::min)(room, length - sent);
+			size_t start = (size_t)(head % _capacity);
+			size_t first = (std::min)(count, _capacity - start);
+			memcpy(_ring + start, input + sent, first);
+			memcpy(_ring, input + sent + first, count - first);
+
+			// Publish the bytes, and wake the receiver if it is waiting for them.
+			head += count;
+			sent += count;
+			_control->head.store(head);
+			_control->head_sequence.fetch_add(1);
+			if (_control->receiver_waiting.load())
+				SharedMemoryStream::Wake(_control->head_sequence);
+
+		}
+
+		return sent;
+
+	}
+	size_t SharedMemoryChannel::Receive(void* buffer, size_t length, int timeout_milliseconds) {
+
+		if (!_control)
+			throw NotSupportedException();
+
+		if (length == 0)
+			return 0;
+
+		// Wait for the sender to publish something.
+		uint64_t tail = _control->tail.load(std::memory_order_relaxed);
+		auto has_data = [&] { return _control->head.load() != tail; };
+		if (!Await(_control->head_sequence, _control->receiver_waiting, has_data, timeout_milliseconds))
+			return 0;
+
+		// Copy as much as is available out of the ring, wrapping around the end.
+		size_t count = (std::min)((size_t)(_control->head.load() - tail), length);
+		size_t start = (size_t)(tail % _capacity);
+		size_t first = (std::min)(count, _capacity - start);
+		memcpy(buffer, _ring + start, first);
+		memcpy((Byte*)buffer + first, _ring, count - first);
+
+		// Release the room, and wake the sender if it is waiting for it.
+		_control->tail.store(tail + count);
+		_control->tail_sequence.fetch_add(1);
+		if (_control->sender_waiting.load())
+			SharedMemoryStream::Wake(_control->tail_sequence);
+
+		return count;
+
+	}
+	void SharedMemoryChannel::Close() {
+
+		_memory.Close();
+		_control = nullptr;
+		_ring = nullptr;
+
+	}
+
+}
+
+#endif
\ No newline at end of file
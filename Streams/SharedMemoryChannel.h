@@ -0,0 +1,50 @@
+#pragma once
+#include "SharedMemoryStream.h"
+
+namespace IO {
+
+	// Provides a single-producer, single-consumer byte channel between two processes, through a ring buffer in a named shared memory object.
+	// Each byte is copied once into the ring by the sender and once out of it by the receiver. Either side blocks on a futex when the ring is full or empty,
+	// and the other side only makes a system call to wake it when it is actually waiting. Available on POSIX platforms only.
+	class SharedMemoryChannel {
+
+	public:
+		// Creates a new channel with the given name, whose ring can hold up to "capacity" bytes. The channel is removed when the side that created it is closed.
+		// Throws IOException if "capacity" is zero.
+		SharedMemoryChannel(const char* name, size_t capacity);
+		// Opens an existing channel with the given name.
+		SharedMemoryChannel(const char* name);
+		SharedMemoryChannel(const SharedMemoryChannel& other) = delete;
+		// Releases all resources used by the channel.
+		~SharedMemoryChannel();
+
+		// Gets the number of bytes the ring can hold.
+		size_t Capacity() const;
+		// Gets the number of bytes that have been sent, but not yet received.
+		size_t Available() const;
+		// Sends "length" bytes, waiting for room in the ring as needed, until all bytes are sent or the timeout expires. A negative timeout waits indefinitely.
+		// Returns the number of bytes sent. May only be called by one thread at a time.
+		size_t Send(const void* buffer, size_t length, int timeout_milliseconds = -1);
+		// Receives up to "length" bytes, waiting until at least one byte is available or the timeout expires. A negative timeout waits indefinitely.
+		// Returns the number of bytes received, which is zero if the timeout expired. May only be called by one thread at a time.
+		size_t Receive(void* buffer, size_t length, int timeout_milliseconds = -1);
+		// Unmaps the channel, and removes it if this side created it.
+		void Close();
+
+		SharedMemoryChannel& operator=(const SharedMemoryChannel& other) = delete;
+
+	private:
+		struct Control;
+
+		// The shared memory holding the control block and the ring.
+		SharedMemoryStream _memory;
+		// The counters shared by both sides, at the beginning of the shared memory.
+		Control* _control;
+		// The ring, which follows the control block.
+		Byte* _ring;
+		// The size of the ring.
+		size_t _capacity;
+
+	};
+
+}
\ No newline at end of file
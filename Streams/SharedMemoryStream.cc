@@ -0,0 +1,404 @@
+#include "SharedMemoryStream.h"
+#include "Exception.h"
+#ifndef _WIN32
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <algorithm>
+#include <new>
+#include <thread>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <climits>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+namespace IO {
+
+	// The header at the beginning of every shared memory object. Its fields are accessed by several processes at once, so they must be lock-free atomics.
+	struct SharedMemoryStream::Header {
+		// Identifies the object as a SharedMemoryStream. Stored last by the creator, so that it also tells other processes that the header is ready.
+		std::atomic<uint32_t> magic;
+		// The number of processes waiting for the generation to change.
+		std::atomic<uint32_t> waiters;
+		// The maximum length of the stream.
+		uint64_t capacity;
+		// The length of the stream.
+		std::atomic<uint64_t> length;
+		// Incremented every time the stream is written to or its length changes.
+		std::atomic<uint32_t> generation;
+	};
+
+	namespace {
+
+		const uint32_t SHARED_MEMORY_MAGIC = 0x53484d53; // "SHMS"
+		// The size reserved for the header, which keeps the contents aligned to a cache line.
+		const size_t HEADER_SIZE = 64;
+		// How long to wait for the creator to finish initializing an object that was opened too early.
+		const int OPEN_TIMEOUT_MILLISECONDS = 1000;
+
+		static_assert(ATOMIC_INT_LOCK_FREE == 2 && ATOMIC_LLONG_LOCK_FREE == 2, "shared memory requires lock-free atomics");
+
+		// Shared memory object names must begin with a slash.
+		std::string ObjectName(const char* name) {
+
+			return name[0] == '/' ? std::string(name) : "/" + std::string(name);
+
+		}
+
+	}
+
+	// Public methods
+
+	SharedMemoryStream::SharedMemoryStream(const char* name, size_t capacity) :
+		_name(ObjectName(name)) {
+
+		_header = nullptr;
+		_data = nullptr;
+		_size = 0;
+		_capacity = capacity;
+		_position = 0;
+		_owner = true;
+
+		_fd = shm_open(_name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+		if (_fd < 0)
+			throw IOException(std::strerror(errno));
+
+		// Size and map the object. The new memory reads as zeros.
+		size_t size = HEADER_SIZE + capacity;
+		if (ftruncate(_fd, (off_t)size) < 0) {
+			int error = errno;
+			Close();
+			throw IOException(std::strerror(error));
+		}
+		Map(size);
+
+		static_assert(sizeof(Header) <= HEADER_SIZE, "the header must fit in the space reserved for it");
+
+		// Initialize the header. The magic number is published last, so that a process opening the object too early waits until the rest is visible.
+		Header* header = new(_header) Header;
+		header->capacity = capacity;
+		header->length.store(0);
+		header->generation.store(0);
+		header->waiters.store(0);
+		header->magic.store(SHARED_MEMORY_MAGIC, std::memory_order_release);
+
+	}
+	SharedMemoryStream::SharedMemoryStream(const char* name) :
+		_name(ObjectName(name)) {
+
+		_header = nullptr;
+		_data = nullptr;
+		_size = 0;
+		_capacity = 0;
+		_position = 0;
+		_owner = false;
+
+		_fd = shm_open(_name.c_str(), O_RDWR, 0);
+		if (_fd < 0) {
+			if (errno == ENOENT)
+				throw FileNotFoundException();
+			throw IOException(std::strerror(errno));
+		}
+
+		// The creator may not have sized or initialized the object yet, so give it a moment to do so.
+		auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(OPEN_TIMEOUT_MILLISECONDS);
+
+		struct stat info;
+		for (;;) {
+			if (fstat(_fd, &info) < 0) {
+				int error = errno;
+				Close();
+				throw IOException(std::strerror(error));
+			}
+			if ((size_t)info.st_size >= HEADER_SIZE || std::chrono::steady_clock::now() >= deadline)
+				break;
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		if ((size_t)info.st_size < HEADER_SIZE) {
+			Close();
+			throw IOException("The shared memory object has not been initialized by its creator.");
+		}
+		Map((size_t)info.st_size);
+
+		uint32_t magic;
+		while ((magic = _header->magic.load(std::memory_order_acquire)) == 0 && std::chrono::steady_clock::now() < deadline)
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+		if (magic == 0) {
+			Close();
+			throw IOException("The shared memory object has not been initialized by its creator.");
+		}
+		if (magic != SHARED_MEMORY_MAGIC || HEADER_SIZE + _header->capacity > _size) {
+			Close();
+			throw IOException("The shared memory object is not a SharedMemoryStream.");
+		}
+		_capacity = (size_t)_header->capacity;
+
+	}
+	SharedMemoryStream::~SharedMemoryStream() {
+
+		Close();
+
+	}
+
+	size_t SharedMemoryStream::Length() {
+
+		return _header ? (size_t)_header->length.load(std::memory_order_acquire) : 0;
+
+	}
+	size_t SharedMemoryStream::Capacity() const {
+
+		return _capacity;
+
+	}
+	size_t SharedMemoryStream::Position() const {
+
+		return _position;
+
+	}
+	Byte* SharedMemoryStream::Data() const {
+
+		return _data;
+
+	}
+	uint32_t SharedMemoryStream::Generation() const {
+
+		return _header ? _header->generation.load(std::memory_order_acquire) : 0;
+
+	}
+	bool SharedMemoryStream::WaitForChange(uint32_t generation, int timeout_milliseconds) {
+
+		// Throw an exception of the stream is not readable.
+		if (!CanRead())
+			throw NotSupportedException();
+
+		// Writers only wake the generation if someone has announced that they are waiting.
+		_header->waiters.fetch_add(1);
+		Wait(_header->generation, generation, timeout_milliseconds);
+		_header->waiters.fetch_sub(1);
+
+		return _header->generation.load(std::memory_order_acquire) != generation;
+
+	}
+	void SharedMemoryStream::Flush() {}
+	void SharedMemoryStream::SetLength(size_t length) {
+
+		// Throw error if the stream does not support writing.
+		if (!CanWrite())
+			throw NotSupportedException();
+
+		if (length > _capacity)
+			throw IOException("The length exceeds the capacity of the shared memory.");
+
+		// If the stream is being extended, clear the new bytes, which may hold data from before it was shortened.
+		size_t old_length = Length();
+		if (length > old_length)
+			memset(_data + old_length, 0, length - old_length);
+
+		_header->length.store(length, std::memory_order_release);
+		Publish();
+
+		// If the length is less than the seek position, move seek position to end.
+		if (_position > length)
+			_position = length;
+
+	}
+	bool SharedMemoryStream::ReadByte(Byte& byte) {
+
+		return Read(&byte, 0, 1) == 1;
+
+	}
+	void SharedMemoryStream::WriteByte(Byte byte) {
+
+		Write(&byte, 0, 1);
+
+	}
+	size_t SharedMemoryStream::Read(void* buffer, size_t offset, size_t length) {
+
+		// Throw an exception of the stream is not readable.
+		if (!CanRead())
+			throw NotSupportedException();
+
+		// Acquiring the length makes the contents written before it was published visible.
+		size_t stream_length = Length();
+
+		// If the stream has been seeked beyond the end of the stream, there is nothing to read.
+		if (_position >= stream_length)
+			return 0;
+
+		// Copy the number of bytes remaining or the requested length-- Whichever is fewer.
+		size_t len = (std::min)(length, stream_length - _position);
+		memcpy((Byte*)buffer + offset * sizeof(Byte), _data + _position, len);
+		_position += len;
+
+		return len;
+
+	}
+	void SharedMemoryStream::Write(const void* buffer, size_t offset, size_t length) {
+
+		// Throw an exception of the stream is not writeable.
+		if (!CanWrite())
+			throw NotSupportedException();
+
+		if (length == 0)
+			return;
+
+		if (_position > _capacity || length > _capacity - _position)
+			throw IOException("The write exceeds the capacity of the shared memory.");
+
+		// Clear any gap between the end of the stream and the position.
+		size_t old_length = Length();
+		if (_position > old_length)
+			memset(_data + old_length, 0, _position - old_length);
+
+		memcpy(_data + _position, (const Byte*)buffer + offset * sizeof(Byte), length);
+		_position += length;
+
+		// Publish the new length (if it grew) after the contents, so that readers never see a length covering bytes that haven't been written.
+		uint64_t current = _header->length.load(std::memory_order_relaxed);
+		while (current < _position && !_header->length.compare_exchange_weak(current, _position, std::memory_order_release, std::memory_order_relaxed));
+
+		Publish();
+
+	}
+	void SharedMemoryStream::Close() {
+
+		if (_header)
+			munmap(_header, _size);
+
+		if (_fd >= 0)
+			close(_fd);
+
+		if (_owner)
+			shm_unlink(_name.c_str());
+
+		_fd = -1;
+		_header = nullptr;
+		_data = nullptr;
+		_size = 0;
+		_position = 0;
+		_owner = false;
+
+	}
+	size_t SharedMemoryStream::Seek(long long offset, SeekOrigin origin) {
+
+		// Throw an exception of the stream is not seekable.
+		if (!CanSeek())
+			throw NotSupportedException();
+
+		// Get the origin position from the seek origin.
+		long long origin_position = 0;
+		switch (origin) {
+		case SeekOrigin::Current:
+			origin_position = (long long)_position;
+			break;
+		case SeekOrigin::End:
+			origin_position = (long long)Length();
+			break;
+		}
+
+		// Throw an error if the new position is less than 0.
+		if (origin_position + offset < 0)
+			throw IOException("An attempt was made to move the position before the beginning of the stream.");
+
+		// Apply the new position.
+		_position = (size_t)(origin_position + offset);
+
+		// Return the new position.
+		return _position;
+
+	}
+	size_t SharedMemoryStream::Seek(long long position) {
+
+		return Seek(position, SeekOrigin::Begin);
+
+	}
+	bool SharedMemoryStream::CanRead() const {
+
+		return _header != nullptr;
+
+	}
+	bool SharedMemoryStream::CanSeek() const {
+
+		return _header != nullptr;
+
+	}
+	bool SharedMemoryStream::CanWrite() const {
+
+		return _header != nullptr;
+
+	}
+	bool SharedMemoryStream::Remove(const char* name) {
+
+		return shm_unlink(ObjectName(name).c_str()) == 0;
+
+	}
+	bool SharedMemoryStream::Wait(std::atomic<uint32_t>& word, uint32_t expected, int timeout_milliseconds) {
+
+		auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_milliseconds);
+
+		while (word.load() == expected) {
+
+			long long remaining = -1;
+			if (timeout_milliseconds >= 0) {
+				remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+				if (remaining <= 0)
+					return false;
+			}
+
+#ifdef __linux__
+			// The futex is shared between processes, so the private variants can't be used. The kernel only sleeps if the word still holds the expected value.
+			struct timespec timeout = { (time_t)(remaining / 1000), (long)(remaining % 1000) * 1000000 };
+			if (syscall(SYS_futex, (uint32_t*)&word, FUTEX_WAIT, expected, remaining >= 0 ? &timeout : nullptr, nullptr, 0) < 0 && errno != EAGAIN && errno != EINTR && errno != ETIMEDOUT)
+				throw IOException(std::strerror(errno));
+#else
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+#endif
+
+		}
+
+		return true;
+
+	}
+	void SharedMemoryStream::Wake(std::atomic<uint32_t>& word) {
+
+#ifdef __linux__
+		syscall(SYS_futex, (uint32_t*)&word, FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+#endif
+
+	}
+
+	// Protected methods
+
+	void SharedMemoryStream::Map(size_t size) {
+
+		void* address = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+		if (address == MAP_FAILED) {
+			int error = errno;
+			Close();
+			throw IOException(std::strerror(error));
+		}
+
+		_header = (Header*)address;
+		_data = (Byte*)address + HEADER_SIZE;
+		_size = size;
+
+	}
+	void SharedMemoryStream::Publish() {
+
+		_header->generation.fetch_add(1);
+
+		// Skip the system call if nobody is waiting.
+		if (_header->waiters.load() > 0)
+			Wake(_header->generation);
+
+	}
+
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,102 @@
+#pragma once
+#include "IStream.h"
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace IO {
+
+	// Provides a Stream over a named POSIX shared memory object, so that processes can exchange data through memory instead of pipes or sockets.
+	// One process creates the object with a fixed capacity, and others open it by name. The length of the stream and a generation counter are kept in a header in the shared memory,
+	// and are updated atomically by every write, so that readers in other processes can tell when there is new data, and can wait for it without polling.
+	// Available on POSIX platforms only.
+	class SharedMemoryStream : public IStream {
+
+	public:
+		// Creates a new shared memory object with the given name that can hold up to "capacity" bytes, and initializes a new instance of the SharedMemoryStream class for it.
+		// Throws IOException if an object with the given name already exists. The object is removed when the stream that created it is closed.
+		SharedMemoryStream(const char* name, size_t capacity);
+		// Initializes a new instance of the SharedMemoryStream class for an existing shared memory object with the given name.
+		// Waits briefly for the creator to finish initializing the object, and throws IOException if it does not.
+		SharedMemoryStream(const char* name);
+		SharedMemoryStream(const SharedMemoryStream& other) = delete;
+		// Releases all resources used by the Stream.
+		virtual ~SharedMemoryStream();
+
+		// Gets the length of the stream in bytes, as last published by any process.
+		virtual size_t Length() override;
+		// Gets the maximum length of the stream.
+		size_t Capacity() const;
+		// Gets the current position within the stream.
+		virtual size_t Position() const override;
+		// Returns the address of the shared contents of the stream, or null if the stream is closed.
+		Byte* Data() const;
+		// Gets the generation of the stream, which is incremented every time the stream is written to or its length changes.
+		uint32_t Generation() const;
+		// Waits until the generation of the stream differs from the given value, or until the timeout expires. A negative timeout waits indefinitely.
+		// Returns true if the generation changed.
+		bool WaitForChange(uint32_t generation, int timeout_milliseconds = -1);
+		// Does nothing, since the contents are shared directly.
+		virtual void Flush() override;
+		// Sets the length of the current stream to the specified value. Throws IOException if the length exceeds the capacity.
+		virtual void SetLength(size_t length) override;
+		// Reads a byte from the stream and advances the position within the stream by one byte, or returns false if at the end of the stream.
+		virtual bool ReadByte(Byte& byte) override;
+		// Writes a byte to the current stream at the current position.
+		virtual void WriteByte(Byte byte) override;
+		// Reads a block of bytes from the current stream and writes the data to a buffer.
+		virtual size_t Read(void* buffer, size_t offset, size_t length) override;
+		// Writes a block of bytes to the current stream using data read from a buffer. Throws IOException if the write would exceed the capacity.
+		virtual void Write(const void* buffer, size_t offset, size_t length) override;
+		// Unmaps the shared memory, and removes the object if this stream created it.
+		virtual void Close() override;
+		// Sets the position within the current stream to the specified value.
+		virtual size_t Seek(long long offset, SeekOrigin origin) override;
+		// Sets the position within the current stream to the specified value.
+		virtual size_t Seek(long long position) override;
+		// Gets a value indicating whether the current stream supports reading.
+		virtual bool CanRead() const override;
+		// Gets a value indicating whether the current stream supports seeking.
+		virtual bool CanSeek() const override;
+		// Gets a value indicating whether the current stream supports writing.
+		virtual bool CanWrite() const override;
+
+		// Removes the shared memory object with the given name. Processes that have it open can keep using it. Returns false if there was no such object.
+		static bool Remove(const char* name);
+		// Waits until the given word in shared memory no longer holds the expected value, it is woken by Wake, or the timeout expires. A negative timeout waits indefinitely.
+		// Returns false if the timeout expired. Uses a futex on Linux, and sleeps briefly between checks elsewhere.
+		static bool Wait(std::atomic<uint32_t>& word, uint32_t expected, int timeout_milliseconds);
+		// Wakes every thread or process waiting on the given word in shared memory.
+		static void Wake(std::atomic<uint32_t>& word);
+
+		SharedMemoryStream& operator=(const SharedMemoryStream& other) = delete;
+
+	protected:
+		// Maps the shared memory object open on the descriptor.
+		void Map(size_t size);
+		// Increments the generation and wakes any waiters.
+		void Publish();
+
+	private:
+		struct Header;
+
+		// The name of the shared memory object.
+		std::string _name;
+		// The descriptor of the shared memory object.
+		int _fd;
+		// The header at the beginning of the mapping.
+		Header* _header;
+		// The contents of the stream, which follow the header.
+		Byte* _data;
+		// The size of the mapping.
+		size_t _size;
+		// The maximum length of the stream.
+		size_t _capacity;
+		// The current position in the stream, which is private to this process.
+		size_t _position;
+		// True if this stream created the object, and removes it when closed.
+		bool _owner;
+
+	};
+
+}
\ No newline at end of file
@@ -0,0 +1,327 @@
+#include "Simd.h"
+#include <cstring>
+#include <algorithm>
+#if defined(__x86_64__) || defined(_M_X64)
+#define STREAMS_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// Allows a function to use an instruction set that the rest of the build doesn't assume. MSVC allows any intrinsic without this.
+#if defined(STREAMS_X86) && (defined(__GNUC__) || defined(__clang__))
+#define STREAMS_TARGET(isa) __attribute__((target(isa)))
+#else
+#define STREAMS_TARGET(isa)
+#endif
+
+namespace IO {
+
+	namespace {
+
+		// The largest range that RotateBytes moves through a temporary buffer on the stack.
+		const size_t ROTATE_STACK_SIZE = 1024;
+
+		void ReverseScalar(Byte* data, size_t length) {
+
+			for (size_t i = 0, j = length; i + 1 < j; ++i, --j)
+				std::swap(data[i], data[j - 1]);
+
+		}
+		void SwapScalar(Byte* first, Byte* second, size_t length) {
+
+			for (size_t i = 0; i < length; ++i)
+				std::swap(first[i], second[i]);
+
+		}
+
+#ifdef STREAMS_X86
+
+		// Each vector kernel reverses the buffer from both ends at once: a vector is loaded from each end, reversed, and stored at the opposite end.
+		// Whatever remains in the middle (less than two vectors) is reversed by the scalar kernel.
+
+		inline __m128i Reverse128(__m128i v) {
+
+			// SSE2 has no byte shuffle, so reverse the dwords, then the words within each dword, then the bytes within each word.
+			v = _mm_shuffle_epi32(v, _MM_SHUFFLE(0, 1, 2, 3));
+			v = _mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+			v = _mm_shufflehi_epi16(v, _MM_SHUFFLE(2, 3, 0, 1));
+			return _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+
+		}
+		void ReverseSSE2(Byte* data, size_t length) {
+
+			Byte* low = data;
+			Byte* high = data + length;
+
+			while (high - low >= 32) {
+				high -= 16;
+				__m128i a = _mm_loadu_si128((const __m128i*)low);
+				__m128i b = _mm_loadu_si128((const __m128i*)high);
+				_mm_storeu_si128((__m128i*)low, Reverse128(b));
+				_mm_storeu_si128((__m128i*)high, Reverse128(a));
+				low += 16;
+			}
+
+			ReverseScalar(low, high - low);
+
+		}
+		void SwapSSE2(Byte* first, Byte* second, size_t length) {
+
+			size_t i = 0;
+			for (; i + 16 <= length; i += 16) {
+				__m128i a = _mm_loadu_si128((const __m128i*)(first + i));
+				__m128i b = _mm_loadu_si128((const __m128i*)(second + i));
+				_mm_storeu_si128((__m128i*)(first + i), b);
+				_mm_storeu_si128((__m128i*)(second + i), a);
+			}
+
+			SwapScalar(first + i, second + i, length - i);
+
+		}
+
+		STREAMS_TARGET("avx2") inline __m256i Reverse256(__m256i v) {
+
+			// Reverse the bytes within each 128-bit lane, then swap the lanes.
+			const __m256i mask = _mm256_setr_epi8(
+				15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0,
+				15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+			v = _mm256_shuffle_epi8(v, mask);
+			return _mm256_permute2x128_si256(v, v, 0x01);
+
+		}
+		STREAMS_TARGET("avx2") void ReverseAVX2(Byte* data, size_t length) {
+
+			Byte* low = data;
+			Byte* high = data + length;
+
+			while (high - low >= 64) {
+				high -= 32;
+				__m256i a = _mm256_loadu_si256((const __m256i*)low);
+				__m256i b = _mm256_loadu_si256((const __m256i*)high);
+				_mm256_storeu_si256((__m256i*)low, Reverse256(b));
+				_mm256_storeu_si256((__m256i*)high, Reverse256(a));
+				low += 32;
+			}
+
+			ReverseSSE2(low, high - low);
+
+		}
+		STREAMS_TARGET("avx2") void SwapAVX2(Byte* first, Byte* second, size_t length) {
+
+			size_t i = 0;
+			for (; i + 32 <= length; i += 32) {
+				__m256i a = _mm256_loadu_si256((const __m256i*)(first + i));
+				__m256i b = _mm256_loadu_si256((const __m256i*)(second + i));
+				_mm256_storeu_si256((__m256i*)(first + i), b);
+				_mm256_storeu_si256((__m256i*)(second + i), a);
+			}
+
+			SwapSSE2(first + i, second + i, length - i);
+
+		}
+
+		STREAMS_TARGET("avx512f,avx512bw") inline __m512i Reverse512(__m512i v) {
+
+			// Reverse the bytes within each 128-bit lane, then reverse the order of the lanes.
+			const __m512i mask = _mm512_set_epi64(
+				0x0001020304050607, 0x08090a0b0c0d0e0f, 0x0001020304050607, 0x08090a0b0c0d0e0f,
+				0x0001020304050607, 0x08090a0b0c0d0e0f, 0x0001020304050607, 0x08090a0b0c0d0e0f);
+			v = _mm512_shuffle_epi8(v, mask);
+			// The zero-masked form of the lane shuffle is used because the unmasked one makes GCC warn about its undefined passthrough operand.
+			return _mm512_maskz_shuffle_i64x2(0xFF, v, v, _MM_SHUFFLE(0, 1, 2, 3));
+
+		}
+		STREAMS_TARGET("avx512f,avx512bw") void ReverseAVX512(Byte* data, size_t length) {
+
+			Byte* low = data;
+			Byte* high = data + length;
+
+			while (high - low >= 128) {
+				high -= 64;
+				__m512i a = _mm512_loadu_si512((const void*)low);
+				__m512i b = _mm512_loadu_si512((const void*)high);
+				_mm512_storeu_si512((void*)low, Reverse512(b));
+				_mm512_storeu_si512((void*)high, Reverse512(a));
+				low += 64;
+			}
+
+			ReverseAVX2(low, high - low);
+
+		}
+		STREAMS_TARGET("avx512f,avx512bw") void SwapAVX512(Byte* first, Byte* second, size_t length) {
+
+			size_t i = 0;
+			for (; i + 64 <= length; i += 64) {
+				__m512i a = _mm512_loadu_si512((const void*)(first + i));
+				__m512i b = _mm512_loadu_si512((const void*)(second + i));
+				_mm512_storeu_si512((void*)(first + i), b);
+				_mm512_storeu_si512((void*)(second + i), a);
+			}
+
+			SwapAVX2(first + i, second + i, length - i);
+
+		}
+
+		SimdLevel QuerySimdLevel() {
+
+#ifdef _MSC_VER
+			int info[4];
+			__cpuid(info, 0);
+			int max_leaf = info[0];
+			if (max_leaf < 7)
+				return SimdLevel::SSE2;
+
+			// The operating system must also save the upper vector registers on context switches.
+			__cpuid(info, 1);
+			bool os_saves_ymm = (info[2] & (1 << 27)) && (_xgetbv(0) & 0x6) == 0x6;
+			bool os_saves_zmm = os_saves_ymm && (_xgetbv(0) & 0xe6) == 0xe6;
+
+			__cpuidex(info, 7, 0);
+			if (os_saves_zmm && (info[1] & (1 << 16)) && (info[1] & (1 << 30)))
+				return SimdLevel::AVX512;
+			if (os_saves_ymm && (info[1] & (1 << 5)))
+				return SimdLevel::AVX2;
+#else
+			__builtin_cpu_init();
+			if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw"))
+				return SimdLevel::AVX512;
+			if (__builtin_cpu_supports("avx2"))
+				return SimdLevel::AVX2;
+#endif
+
+			// SSE2 is part of the x86-64 baseline.
+			return SimdLevel::SSE2;
+
+		}
+
+#else
+
+		SimdLevel QuerySimdLevel() {
+
+			return SimdLevel::Scalar;
+
+		}
+
+#endif
+
+	}
+
+	SimdLevel DetectSimdLevel() {
+
+		static const SimdLevel level = QuerySimdLevel();
+		return level;
+
+	}
+
+	void ReverseBytes(Byte* data, size_t length) {
+
+		ReverseBytes(data, length, DetectSimdLevel());
+
+	}
+	void ReverseBytes(Byte* data, size_t length, SimdLevel level) {
+
+		switch (level) {
+#ifdef STREAMS_X86
+		case SimdLevel::AVX512:
+			ReverseAVX512(data, length);
+			break;
+		case SimdLevel::AVX2:
+			ReverseAVX2(data, length);
+			break;
+		case SimdLevel::SSE2:
+			ReverseSSE2(data, length);
+			break;
+#endif
+		default:
+			ReverseScalar(data, length);
+			break;
+		}
+
+	}
+	void SwapBytes(Byte* first, Byte* second, size_t length) {
+
+		SwapBytes(first, second, length, DetectSimdLevel());
+
+	}
+	void SwapBytes(Byte* first, Byte* second, size_t length, SimdLevel level) {
+
+		switch (level) {
+#ifdef STREAMS_X86
+		case SimdLevel::AVX512:
+			SwapAVX512(first, second, length);
+			break;
+		case SimdLevel::AVX2:
+			SwapAVX2(first, second, length);
+			break;
+		case SimdLevel::SSE2:
+			SwapSSE2(first, second, length);
+			break;
+#endif
+		default:
+			SwapScalar(first, second, length);
+			break;
+		}
+
+	}
+	void RotateBytes(Byte* data, size_t length, size_t amount) {
+
+		RotateBytes(data, length, amount, DetectSimdLevel());
+
+	}
+	void RotateBytes(Byte* data, size_t length, size_t amount, SimdLevel level) {
+
+		if (length == 0)
+			return;
+
+		amount %= length;
+		if (amount == 0)
+			return;
+
+		// The bytes that move to the beginning ("tail"), and the bytes that move to the end ("head").
+		size_t tail = amount;
+		size_t head = length - amount;
+
+		// If either part is small, move it aside, slide the other part over, and put it back. Each byte is copied once, apart from the small part.
+		if ((std::min)(head, tail) <= ROTATE_STACK_SIZE) {
+
+			Byte temp[ROTATE_STACK_SIZE];
+
+			if (tail <= head) {
+				memcpy(temp, data + head, tail);
+				memmove(data + tail, data, head);
+				memcpy(data, temp, tail);
+			}
+			else {
+				memcpy(temp, data, head);
+				memmove(data, data + head, tail);
+				memcpy(data + tail, temp, head);
+			}
+
+			return;
+
+		}
+
+		// Otherwise, rotate by swapping blocks (Gries and Mills): each swap puts one block in its final place, and the remaining two blocks are rotated in turn.
+		// Once either block is small, the rest is finished as above, since the blocks can otherwise shrink to a few bytes and take many tiny swaps.
+		Byte* first = data;
+		size_t a = head;
+		size_t b = tail;
+		while (a > ROTATE_STACK_SIZE && b > ROTATE_STACK_SIZE) {
+			if (a <= b) {
+				SwapBytes(first, first + a, a, level);
+				first += a;
+				b -= a;
+			}
+			else {
+				SwapBytes(first + a - b, first + a, b, level);
+				a -= b;
+			}
+		}
+
+		RotateBytes(first, a + b, b, level);
+
+	}
+
+}
\ No newline at end of file
@@ -0,0 +1,35 @@
+#pragma once
+#include "IO.h"
+
+namespace IO {
+
+	// Defines the instruction sets that byte kernels can be dispatched to, from least to most capable.
+	enum class SimdLevel {
+		// Portable code only.
+		Scalar,
+		// 128-bit vectors (SSE2).
+		SSE2,
+		// 256-bit vectors (AVX2).
+		AVX2,
+		// 512-bit vectors (AVX-512BW).
+		AVX512
+	};
+
+	// Returns the most capable instruction set supported by both the processor and the build. Detected once, on first use.
+	SimdLevel DetectSimdLevel();
+
+	// Reverses the order of "length" bytes in place, using the most capable instruction set available.
+	void ReverseBytes(Byte* data, size_t length);
+	// Reverses the order of "length" bytes in place, using the given instruction set, which must be supported by the processor.
+	void ReverseBytes(Byte* data, size_t length, SimdLevel level);
+	// Exchanges the contents of two non-overlapping ranges of "length" bytes, using the most capable instruction set available.
+	void SwapBytes(Byte* first, Byte* second, size_t length);
+	// Exchanges the contents of two non-overlapping ranges of "length" bytes, using the given instruction set, which must be supported by the processor.
+	void SwapBytes(Byte* first, Byte* second, size_t length, SimdLevel level);
+	// Rotates "length" bytes in place towards the end by "amount" bytes, so that the last "amount" bytes move to the beginning.
+	// Each byte is moved once (rather than twice, as with three reversals).
+	void RotateBytes(Byte* data, size_t length, size_t amount);
+	// Rotates "length" bytes in place towards the end by "amount" bytes, using the given instruction set, which must be supported by the processor.
+	void RotateBytes(Byte* data, size_t length, size_t amount, SimdLevel level);
+
+}
\ No newline at end of file
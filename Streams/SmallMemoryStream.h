@@ -0,0 +1,35 @@
+#pragma once
+#include "MemoryStream.h"
+#include <cstddef>
+
+namespace IO {
+
+	// Provides a MemoryStream that keeps up to "InlineCapacity" bytes inside the object itself, and only allocates from the heap once it outgrows them.
+	// Useful for the many small payloads (headers, short messages) that would otherwise cost an allocation each.
+	template <size_t InlineCapacity = 256>
+	class SmallMemoryStream : public MemoryStream {
+
+	public:
+		// Initializes a new instance of the SmallMemoryStream class, whose buffer is allocated with the default allocator once it spills to the heap.
+		SmallMemoryStream() : SmallMemoryStream(Allocator::Default()) {}
+		// Initializes a new instance of the SmallMemoryStream class, whose buffer is allocated with the given allocator once it spills to the heap.
+		SmallMemoryStream(Allocator& allocator) : MemoryStream(_storage, InlineCapacity, allocator) {}
+		SmallMemoryStream(const SmallMemoryStream& other) = delete;
+
+		// Returns the number of bytes that can be stored without allocating.
+		static constexpr size_t InlineSize() {
+
+			return InlineCapacity;
+
+		}
+
+		SmallMemoryStream& operator=(const SmallMemoryStream& other) = delete;
+
+	private:
+		static_assert(InlineCapacity > 0, "InlineCapacity must be greater than zero");
+
+		alignas(std::max_align_t) Byte _storage[InlineCapacity];
+
+	};
+
+}
\ No newline at end of file
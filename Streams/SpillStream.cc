@@ -0,0 +1,293 @@
+#include "SpillStream.h"
+#include "BufferedStream.h"
+#include "Exception.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+namespace IO {
+
+	namespace {
+
+		// The threshold used by default.
+		const size_t DEFAULT_SPILL_THRESHOLD = 16 * 1024 * 1024;
+		// The size of the buffer in front of the temporary file.
+		const size_t SPILL_BUFFER_SIZE = 64 * 1024;
+
+		// Creates a new, empty file with a unique name in the given directory (or the system's temporary directory if it is empty), and returns its path.
+		std::string CreateTempFile(const std::string& directory) {
+
+#ifdef _WIN32
+			char* name = _tempnam(directory.empty() ? nullptr : directory.c_str(), "spill");
+			if (!name)
+				throw IOException("Unable to create a temporary file name.");
+
+			std::string path(name);
+			free(name);
+
+			FileStream(path.c_str(), FileMode::CreateNew, FileAccess::Write).Close();
+
+			return path;
+#else
+			std::string path = directory;
+			if (path.empty()) {
+				const char* tmpdir = getenv("TMPDIR");
+				path = tmpdir && *tmpdir ? tmpdir : "/tmp";
+			}
+			path += "/spill-XXXXXX";
+
+			int fd = mkstemp(&path[0]);
+			if (fd < 0)
+				throw IOException(std::strerror(errno));
+			close(fd);
+
+			return path;
+#endif
+
+		}
+
+	}
+
+	// Public methods
+
+	SpillStream::SpillStream() : SpillStream(DEFAULT_SPILL_THRESHOLD) {}
+	SpillStream::SpillStream(size_t threshold) : SpillStream(threshold, nullptr) {}
+	SpillStream::SpillStream(size_t threshold, const char* directory) :
+		_directory(directory ? directory : "") {
+
+		_threshold = threshold;
+
+	}
+	SpillStream::~SpillStream() {
+
+		Close();
+
+	}
+
+	size_t SpillStream::Length() {
+
+		return Active().Length();
+
+	}
+	size_t SpillStream::Position() const {
+
+		return Active().Position();
+
+	}
+	size_t SpillStream::Threshold() const {
+
+		return _threshold;
+
+	}
+	bool SpillStream::IsSpilled() const {
+
+		return _file != nullptr;
+
+	}
+	void SpillStream::Flush() {
+
+		Active().Flush();
+
+	}
+	void SpillStream::SetLength(size_t length) {
+
+		// Throw error if the stream does not support writing.
+		if (!CanWrite())
+			throw NotSupportedException();
+
+		SpillIfNeeded(length);
+
+		Active().SetLength(length);
+
+	}
+	bool SpillStream::ReadByte(Byte& byte) {
+
+		return Active().ReadByte(byte);
+
+	}
+	void SpillStream::WriteByte(Byte byte) {
+
+		Write(&byte, 0, 1);
+
+	}
+	size_t SpillStream::Read(void* buffer, size_t offset, size_t length) {
+
+		return Active().Read(buffer, offset, length);
+
+	}
+	void SpillStream::Write(const void* buffer, size_t offset, size_t length) {
+
+		// Throw an exception of the stream is not writeable.
+		if (!CanWrite())
+			throw NotSupportedException();
+
+		SpillIfNeeded(Position() + length);
+
+		Active().Write(buffer, offset, length);
+
+	}
+	size_t SpillStream::ReadAt(size_t position, void* buffer, size_t length) {
+
+		// Positional reads go straight to the file, once anything buffered has been written to it.
+		if (_file) {
+			_buffered->Flush();
+			return _file->ReadAt(position, buffer, length);
+		}
+
+		return _memory.ReadAt(position, buffer, length);
+
+	}
+	void SpillStream::WriteAt(size_t position, const void* buffer, size_t length) {
+
+		// Throw an exception of the stream is not writeable.
+		if (!CanWrite())
+			throw NotSupportedException();
+
+		SpillIfNeeded(position + length);
+
+		// Positional writes go straight to the file, once anything buffered has been written to it.
+		if (_file) {
+			_buffered->Flush();
+			_file->WriteAt(position, buffer, length);
+			return;
+		}
+
+		_memory.WriteAt(position, buffer, length);
+
+	}
+	void SpillStream::Close() {
+
+		_memory.Close();
+
+		if (_file) {
+
+			// The file is about to be deleted, so anything still buffered is discarded.
+			_buffered.reset();
+			_file->Close();
+			_file.reset();
+
+			// On Windows, the file can't be unlinked while it is open, so it is deleted here instead.
+			if (!_path.empty())
+				std::remove(_path.c_str());
+			_path.clear();
+
+		}
+
+	}
+	void SpillStream::CopyTo(IStream& stream) {
+
+		// Copy from the file itself, so that the copy can be performed by the kernel.
+		if (_file) {
+			_buffered->Flush();
+			_file->CopyTo(stream);
+			return;
+		}
+
+		_memory.CopyTo(stream);
+
+	}
+	void SpillStream::CopyTo(IStream& stream, size_t buffer_size) {
+
+		// Copy from the file itself, so that the copy can be performed by the kernel.
+		if (_file) {
+			_buffered->Flush();
+			_file->CopyTo(stream, buffer_size);
+			return;
+		}
+
+		_memory.CopyTo(stream, buffer_size);
+
+	}
+	size_t SpillStream::Seek(long long offset, SeekOrigin origin) {
+
+		return Active().Seek(offset, origin);
+
+	}
+	size_t SpillStream::Seek(long long position) {
+
+		return Active().Seek(position);
+
+	}
+	bool SpillStream::CanRead() const {
+
+		return Active().CanRead();
+
+	}
+	bool SpillStream::CanSeek() const {
+
+		return Active().CanSeek();
+
+	}
+	bool SpillStream::CanWrite() const {
+
+		return Active().CanWrite();
+
+	}
+
+	// Protected methods
+
+	IStream& SpillStream::Active() {
+
+		return _file ? (IStream&)*_buffered : (IStream&)_memory;
+
+	}
+	const IStream& SpillStream::Active() const {
+
+		return _file ? (const IStream&)*_buffered : (const IStream&)_memory;
+
+	}
+	void SpillStream::SpillIfNeeded(size_t length) {
+
+		if (!_file && length > _threshold)
+			Spill();
+
+	}
+	void SpillStream::Spill() {
+
+		std::string path = CreateTempFile(_directory);
+
+		std::unique_ptr<FileStream> file;
+		try {
+			file.reset(new FileStream(path.c_str(), FileMode::Open, FileAccess::ReadWrite));
+		}
+		catch (...) {
+			std::remove(path.c_str());
+			throw;
+		}
+
+#ifndef _WIN32
+		// The file stays accessible through the open descriptor, and is removed by the system when it is closed, even if the process exits abruptly.
+		unlink(path.c_str());
+#endif
+
+		// Copy the contents of the memory stream to the file, and carry the position over. If that fails (such as when the disk is full), the file must not outlive the call.
+		try {
+			ConstSpan contents = _memory.GetSpan();
+			file->Write(contents.data, 0, contents.length);
+			file->Seek(_memory.Position());
+		}
+		catch (...) {
+			file.reset();
+#ifdef _WIN32
+			std::remove(path.c_str());
+#endif
+			throw;
+		}
+
+		_file = std::move(file);
+		_buffered.reset(new BufferedSteam(*_file, SPILL_BUFFER_SIZE));
+#ifdef _WIN32
+		// Only recorded once the file is installed, so that Close deletes it exactly when it is in use.
+		_path = path;
+#endif
+
+		// The memory is no longer needed.
+		_memory.Close();
+
+	}
+
+}
\ No newline at end of file
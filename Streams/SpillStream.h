@@ -0,0 +1,96 @@
+#pragma once
+#include "IStream.h"
+#include "MemoryStream.h"
+#include "FileStream.h"
+#include <memory>
+#include <string>
+
+namespace IO {
+
+	class BufferedSteam;
+
+	// Provides a Stream that is kept in memory until its length exceeds a threshold, after which its contents are moved to a temporary file and the stream continues there.
+	// This keeps small intermediate results in memory, without running out of memory when a large one comes along. The temporary file is deleted when the stream is closed.
+	class SpillStream : public IStream {
+
+	public:
+		// Initializes a new instance of the SpillStream class with the default threshold, which spills to the system's temporary directory.
+		SpillStream();
+		// Initializes a new instance of the SpillStream class that spills to the system's temporary directory once it grows beyond "threshold" bytes.
+		SpillStream(size_t threshold);
+		// Initializes a new instance of the SpillStream class that spills to a temporary file in the given directory once it grows beyond "threshold" bytes.
+		SpillStream(size_t threshold, const char* directory);
+		SpillStream(const SpillStream& other) = delete;
+		// Releases all resources used by the Stream, and deletes the temporary file.
+		virtual ~SpillStream();
+
+		// Gets the length of the stream in bytes.
+		virtual size_t Length() override;
+		// Gets the current position within the stream.
+		virtual size_t Position() const override;
+		// Gets the length beyond which the stream is moved to a temporary file.
+		size_t Threshold() const;
+		// Returns true if the stream has been moved to a temporary file.
+		bool IsSpilled() const;
+		// Writes any buffered data to the temporary file, if the stream has been spilled.
+		virtual void Flush() override;
+		// Sets the length of the current stream to the specified value, spilling the stream if the new length exceeds the threshold.
+		virtual void SetLength(size_t length) override;
+		// Reads a byte from the stream and advances the position within the stream by one byte, or returns false if at the end of the stream.
+		virtual bool ReadByte(Byte& byte) override;
+		// Writes a byte to the current stream at the current position.
+		virtual void WriteByte(Byte byte) override;
+		// Reads a block of bytes from the current stream and writes the data to a buffer.
+		virtual size_t Read(void* buffer, size_t offset, size_t length) override;
+		// Writes a block of bytes to the current stream using data read from a buffer, spilling the stream first if it would grow beyond the threshold.
+		virtual void Write(const void* buffer, size_t offset, size_t length) override;
+		// Reads a block of bytes beginning at the given position in the stream, without using or changing the current position.
+		virtual size_t ReadAt(size_t position, void* buffer, size_t length) override;
+		// Writes a block of bytes beginning at the given position in the stream, without using or changing the current position.
+		virtual void WriteAt(size_t position, const void* buffer, size_t length) override;
+		// Closes the current stream, releasing its memory and deleting the temporary file.
+		virtual void Close() override;
+		// Reads the bytes from the current stream and writes them to another stream.
+		virtual void CopyTo(IStream& stream) override;
+		// Reads the bytes from the current stream and writes them to another stream, using the given buffer size if the stream has been spilled.
+		virtual void CopyTo(IStream& stream, size_t buffer_size) override;
+		using IStream::CopyTo;
+		// Sets the position within the current stream to the specified value.
+		virtual size_t Seek(long long offset, SeekOrigin origin) override;
+		// Sets the position within the current stream to the specified value.
+		virtual size_t Seek(long long position) override;
+		// Gets a value indicating whether the current stream supports reading.
+		virtual bool CanRead() const override;
+		// Gets a value indicating whether the current stream supports seeking.
+		virtual bool CanSeek() const override;
+		// Gets a value indicating whether the current stream supports writing.
+		virtual bool CanWrite() const override;
+
+		SpillStream& operator=(const SpillStream& other) = delete;
+
+	protected:
+		// Returns the stream currently holding the contents: the buffered temporary file if the stream has been spilled, and the memory stream otherwise.
+		IStream& Active();
+		const IStream& Active() const;
+		// Spills the stream if it is still in memory and "length" exceeds the threshold.
+		void SpillIfNeeded(size_t length);
+		// Moves the contents of the stream to a new temporary file, keeping the current position.
+		void Spill();
+
+	private:
+		// The contents of the stream until it is spilled.
+		MemoryStream _memory;
+		// The temporary file holding the contents of the stream once it is spilled, or null.
+		std::unique_ptr<FileStream> _file;
+		// Buffers sequential reads and writes to the temporary file, so that small ones don't each cost a system call.
+		std::unique_ptr<BufferedSteam> _buffered;
+		// The path of the temporary file. On POSIX platforms the file is unlinked as soon as it is opened, and this is empty.
+		std::string _path;
+		// The directory in which to create the temporary file, or empty to use the system's temporary directory.
+		std::string _directory;
+		// The length beyond which the stream is spilled.
+		size_t _threshold;
+
+	};
+
+}
\ No newline at end of file
@@ -0,0 +1,108 @@
+#include "IO.h"
+#include "Simd.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <vector>
+
+// Times the SIMD byte kernels at every instruction set supported by the processor, against the standard library algorithms they replace.
+// Results are reported as throughput in MB/s, along with the speedup over the standard library.
+
+namespace {
+
+	// The buffer sizes to time each kernel at, from cache-resident to well beyond the last level cache.
+	const size_t BENCHMARK_SIZES[] = { 256, 4 * 1024, 64 * 1024, 1024 * 1024, 16 * 1024 * 1024 };
+	// The number of bytes to process for each measurement, so that small buffers are timed over many iterations.
+	const size_t BYTES_PER_MEASUREMENT = 256 * 1024 * 1024;
+	// The number of measurements to take for each kernel, of which the fastest is reported.
+	const int MEASUREMENTS = 5;
+
+	const char* LevelName(IO::SimdLevel level) {
+
+		switch (level) {
+		case IO::SimdLevel::SSE2:
+			return "SSE2";
+		case IO::SimdLevel::AVX2:
+			return "AVX2";
+		case IO::SimdLevel::AVX512:
+			return "AVX512";
+		default:
+			return "Scalar";
+		}
+
+	}
+	// Runs "kernel" over a buffer of "size" bytes enough times to process BYTES_PER_MEASUREMENT bytes, and returns the best throughput in MB/s.
+	double Measure(size_t size, const std::function<void(IO::Byte*, size_t)>& kernel) {
+
+		std::vector<IO::Byte> buffer(size);
+		for (size_t i = 0; i < size; ++i)
+			buffer[i] = (IO::Byte)(i * 31);
+
+		size_t iterations = (std::max)(BYTES_PER_MEASUREMENT / size, (size_t)1);
+		double best = 0.0;
+
+		for (int i = 0; i < MEASUREMENTS; ++i) {
+
+			auto start = std::chrono::steady_clock::now();
+			for (size_t j = 0; j < iterations; ++j)
+				kernel(buffer.data(), size);
+			auto end = std::chrono::steady_clock::now();
+
+			double seconds = std::chrono::duration<double>(end - start).count();
+			if (seconds > 0.0)
+				best = (std::max)(best, (double)(size * iterations) / seconds / (1024.0 * 1024.0));
+
+		}
+
+		// Keep the result observable, so that the work can't be optimized away.
+		volatile IO::Byte sink = buffer[size / 2];
+		(void)sink;
+
+		return best;
+
+	}
+	// Times a kernel at every supported instruction set against the given baseline, and prints one row per buffer size and instruction set.
+	void Benchmark(const char* name, const std::function<void(IO::Byte*, size_t)>& baseline, const std::function<void(IO::Byte*, size_t, IO::SimdLevel)>& kernel) {
+
+		IO::SimdLevel supported = IO::DetectSimdLevel();
+
+		for (size_t size : BENCHMARK_SIZES) {
+
+			double baseline_throughput = Measure(size, baseline);
+			printf("%-8s %10zu  %-8s %10.0f MB/s\n", name, size, "std", baseline_throughput);
+
+			for (int level = (int)IO::SimdLevel::Scalar; level <= (int)supported; ++level) {
+				double throughput = Measure(size, [&](IO::Byte* data, size_t length) { kernel(data, length, (IO::SimdLevel)level); });
+				printf("%-8s %10zu  %-8s %10.0f MB/s  %5.2fx\n", name, size, LevelName((IO::SimdLevel)level), throughput, throughput / baseline_throughput);
+			}
+
+		}
+
+	}
+
+}
+
+int main() {
+
+	printf("Detected instruction set: %s\n\n", LevelName(IO::DetectSimdLevel()));
+	printf("%-8s %10s  %-8s %15s  %6s\n", "Kernel", "Bytes", "Level", "Throughput", "Speedup");
+
+	Benchmark("Reverse",
+		[](IO::Byte* data, size_t length) { std::reverse(data, data + length); },
+		[](IO::Byte* data, size_t length, IO::SimdLevel level) { IO::ReverseBytes(data, length, level); });
+
+	// Swap the two halves of the buffer with each other.
+	Benchmark("Swap",
+		[](IO::Byte* data, size_t length) { std::swap_ranges(data, data + length / 2, data + length / 2); },
+		[](IO::Byte* data, size_t length, IO::SimdLevel level) { IO::SwapBytes(data, data + length / 2, length / 2, level); });
+
+	// Rotate by an amount that leaves neither part small, so that the block swapping path is taken.
+	Benchmark("Rotate",
+		[](IO::Byte* data, size_t length) { std::rotate(data, data + length - length / 3, data + length); },
+		[](IO::Byte* data, size_t length, IO::SimdLevel level) { IO::RotateBytes(data, length, length / 3, level); });
+
+	return 0;
+
+}
\ No newline at end of file
@@ -2,7 +2,38 @@
 #include "IO.h"
 #include "BitReader.h"
 #include "BitWriter.h"
+#include "ArenaAllocator.h"
+#include "Buffer.h"
+#include "Simd.h"
+#include "BufferPool.h"
+#include "BufferedStream.h"
 #include "MemoryStream.h"
+#include "MemoryStreamView.h"
+#include "SegmentedMemoryStream.h"
+#include "SharedMemoryChannel.h"
+#include "SharedMemoryStream.h"
+#include "SpillStream.h"
+#include "SmallMemoryStream.h"
+#include "FileStream.h"
+#include "FileHandleCache.h"
+#include "GroupCommit.h"
+#include "AppendStream.h"
+#include "AsyncFileStream.h"
+#include "MappedFileStream.h"
+#include "PageAllocator.h"
+#include "Exception.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
 using namespace Microsoft::VisualStudio::CppUnitTestFramework;
 
 namespace Tests {
@@ -51,6 +82,1180 @@ public:
 	}
 	};
 
+	TEST_CLASS(BufferPoolTests) {
+public:
+	// Tests that rented buffers are rounded up to the size of their size class.
+	TEST_METHOD(BucketSizeRoundsUpToPowerOfTwo) {
+
+		IO::BufferPool pool;
+
+		Assert::AreEqual((size_t)16, pool.BucketSize(1));
+		Assert::AreEqual((size_t)128, pool.BucketSize(100));
+		Assert::AreEqual((size_t)128, pool.BucketSize(128));
+
+	}
+	// Tests that a returned buffer is reused by the next rental in the same size class.
+	TEST_METHOD(ReturnedBufferIsReused) {
+
+		IO::BufferPool pool;
+
+		IO::Byte* first = pool.Rent(100);
+		pool.Return(first, 100);
+		IO::Byte* second = pool.Rent(120);
+
+		Assert::IsTrue(first == second);
+
+		pool.Return(second, 120);
+
+	}
+	};
+
+	TEST_CLASS(BufferTests) {
+public:
+	// Tests that reversing gives the same result with every instruction set the processor supports, for lengths around each vector width.
+	TEST_METHOD(ReverseMatchesAtEverySimdLevel) {
+
+		std::vector<IO::Byte> input(1000);
+		for (size_t i = 0; i < input.size(); ++i)
+			input[i] = (IO::Byte)(i * 31 + 7);
+
+		for (int level = 0; level <= (int)IO::DetectSimdLevel(); ++level) {
+			for (size_t length = 0; length <= input.size(); length += (length < 300 ? 1 : 97)) {
+				std::vector<IO::Byte> expected(input.begin(), input.begin() + length);
+				std::vector<IO::Byte> actual = expected;
+				std::reverse(expected.begin(), expected.end());
+				IO::ReverseBytes(actual.data(), length, (IO::SimdLevel)level);
+				Assert::IsTrue(actual == expected);
+			}
+		}
+
+	}
+	// Tests that RotateBytes matches std::rotate at every instruction set the processor supports, including amounts where the blocks being swapped shrink unevenly.
+	TEST_METHOD(RotateMatchesAtEverySimdLevel) {
+
+		const size_t size = 5000;
+		size_t amounts[] = { 1, 1024, 1666, 1667, 2500, 3333, 4999 };
+
+		for (int level = 0; level <= (int)IO::DetectSimdLevel(); ++level) {
+			for (size_t amount : amounts) {
+				std::vector<IO::Byte> expected(size);
+				for (size_t i = 0; i < size; ++i)
+					expected[i] = (IO::Byte)(i * 13);
+				std::vector<IO::Byte> actual = expected;
+				std::rotate(expected.begin(), expected.end() - amount, expected.end());
+				IO::RotateBytes(actual.data(), size, amount, (IO::SimdLevel)level);
+				Assert::IsTrue(actual == expected);
+			}
+		}
+
+	}
+	// Tests that rotating a buffer in either direction matches std::rotate, for small amounts and for amounts too large to move through the stack.
+	TEST_METHOD(RotateMatchesStdRotate) {
+
+		const int size = 5000;
+		int amounts[] = { 0, 1, -1, 17, -17, 1024, 2000, -2000, 2500, 4999, size, size + 3, -size - 3 };
+
+		for (int amount : amounts) {
+			IO::Buffer buffer(size);
+			std::vector<IO::Byte> expected(size);
+			for (int i = 0; i < size; ++i)
+				buffer[i] = expected[i] = (IO::Byte)(i * 13);
+
+			buffer.Rotate(amount);
+			int shift = ((amount % size) + size) % size;
+			std::rotate(expected.begin(), expected.end() - shift, expected.end());
+
+			Assert::IsTrue(memcmp(buffer.Pointer(), expected.data(), size) == 0);
+		}
+
+	}
+	// Tests that an aligned buffer keeps its alignment, contents and zeroed padding as it is resized, copied and moved.
+	TEST_METHOD(AlignmentSurvivesResize) {
+
+		IO::Buffer buffer(100, IO::BufferAlignment::Bytes64, 32);
+		Assert::AreEqual((size_t)64, buffer.Alignment());
+		Assert::IsTrue(IO::IsAligned(buffer.Pointer(), 64));
+		for (size_t i = 0; i < buffer.Size(); ++i)
+			buffer[i] = (IO::Byte)i;
+
+		size_t sizes[] = { 1000, 3, 5000 };
+		for (size_t size : sizes) {
+			buffer.Resize(size, true);
+			Assert::IsTrue(IO::IsAligned(buffer.Pointer(), 64));
+			Assert::AreEqual((IO::Byte)2, buffer[2]);
+			for (size_t i = 0; i < buffer.Padding(); ++i)
+				Assert::AreEqual((IO::Byte)0, buffer.Pointer()[size + i]);
+		}
+
+		IO::Buffer copy(buffer);
+		Assert::IsTrue(IO::IsAligned(copy.Pointer(), 64));
+		Assert::AreEqual((size_t)32, copy.Padding());
+
+		IO::Buffer assigned(10);
+		assigned = buffer;
+		Assert::AreEqual((size_t)64, assigned.Alignment());
+		Assert::AreEqual((size_t)32, assigned.Padding());
+		Assert::IsTrue(IO::IsAligned(assigned.Pointer(), 64));
+		Assert::AreEqual((IO::Byte)2, assigned[2]);
+
+		IO::Buffer page(10, IO::BufferAlignment::Page);
+		page.Reserve(IO::PageSize() + 1);
+		Assert::IsTrue(IO::IsAligned(page.Pointer(), IO::PageSize()));
+
+		IO::Buffer moved(std::move(page));
+		Assert::IsTrue(IO::IsAligned(moved.Pointer(), IO::PageSize()));
+
+	}
+	};
+
+	TEST_CLASS(ArenaAllocatorTests) {
+public:
+	// Tests that allocations are aligned, that the most recent allocation grows in place, and that released memory is reused.
+	TEST_METHOD(AllocateGrowAndRelease) {
+
+		IO::ArenaAllocator arena(256);
+
+		void* first = arena.Allocate(3);
+		void* second = arena.Allocate(10);
+		Assert::IsTrue(IO::IsAligned(second, alignof(std::max_align_t)));
+
+		// Only the most recent allocation can be resized in place.
+		Assert::IsTrue(arena.Reallocate(second, 10, 100) == second);
+		Assert::IsTrue(arena.Reallocate(first, 3, 8) != first);
+
+		// Allocations larger than a block get a block of their own.
+		void* large = arena.Allocate(4096);
+		memset(large, 1, 4096);
+
+		arena.Release();
+		Assert::AreEqual((size_t)0, arena.BytesAllocated());
+		Assert::IsTrue(arena.Allocate(16) != nullptr);
+
+	}
+	// Tests that a memory stream, buffer and bit writer can all allocate from the same arena.
+	TEST_METHOD(StreamsAllocateFromArena) {
+
+		IO::ArenaAllocator arena;
+
+		{
+			IO::MemoryStream ms(arena);
+			IO::BitWriter writer(ms, arena);
+			for (int i = 0; i < 100; ++i)
+				writer.WriteInteger(i);
+			writer.Flush();
+			Assert::AreEqual((size_t)400, ms.Length());
+
+			IO::Buffer buffer(64, arena, true);
+			buffer.Resize(128, true);
+			Assert::AreEqual((IO::Byte)0, buffer[127]);
+		}
+
+		Assert::IsTrue(arena.BytesAllocated() >= 400);
+
+	}
+	// Tests that empty streams allocated from the same arena get buffers of their own.
+	TEST_METHOD(EmptyStreamsDoNotShareBuffers) {
+
+		IO::ArenaAllocator arena;
+		IO::MemoryStream first(arena);
+		IO::MemoryStream second(arena);
+
+		first.Write("AAAAAAAA", 0, 8);
+		second.Write("BBBBBBBB", 0, 8);
+
+		Assert::IsTrue(first.GetSpan().data != second.GetSpan().data);
+		Assert::AreEqual(0, memcmp(first.GetSpan().data, "AAAAAAAA", 8));
+		Assert::AreEqual(0, memcmp(second.GetSpan().data, "BBBBBBBB", 8));
+
+	}
+	};
+
+#ifndef _WIN32
+	TEST_CLASS(PageAllocatorTests) {
+public:
+	// Tests that a memory stream above the threshold is mapped, keeps its contents as the mapping grows, and returns the mapping when it shrinks or closes.
+	TEST_METHOD(LargeStreamsAreMapped) {
+
+		IO::PageAllocator allocator(64 * 1024, IO::HugePageMode::Transparent);
+		IO::MemoryStream ms(allocator);
+
+		IO::Byte block[4096];
+		for (int i = 0; i < 256; ++i) {
+			memset(block, i, sizeof(block));
+			ms.Write(block, 0, sizeof(block));
+		}
+		Assert::IsTrue(allocator.BytesMapped() >= 1024 * 1024);
+
+		IO::ConstSpan contents = ms.GetSpan();
+		Assert::AreEqual((IO::Byte)0, contents.data[0]);
+		Assert::AreEqual((IO::Byte)100, contents.data[100 * 4096 + 17]);
+		Assert::AreEqual((IO::Byte)255, contents.data[contents.length - 1]);
+
+		// Shrinking below the threshold moves the contents back to the heap.
+		ms.SetLength(100);
+		Assert::AreEqual((size_t)0, allocator.BytesMapped());
+		Assert::AreEqual((IO::Byte)0, ms.GetSpan().data[99]);
+
+		ms.SetLength(128 * 1024);
+		Assert::IsTrue(allocator.BytesMapped() > 0);
+		ms.Close();
+		Assert::AreEqual((size_t)0, allocator.BytesMapped());
+
+	}
+	};
+#endif
+
+	// A memory stream that records the access hints given to it, so that tests can check that wrappers forward them.
+	class HintRecordingStream : public IO::MemoryStream {
+	public:
+		// A single call to Advise or Prefetch. Prefetch calls are recorded with the "WillNeed" pattern.
+		struct Hint {
+			bool prefetch;
+			IO::AccessPattern pattern;
+			size_t offset;
+			size_t length;
+		};
+
+		std::vector<Hint> hints;
+
+		void Advise(IO::AccessPattern pattern, size_t offset, size_t length) override {
+
+			hints.push_back(Hint{ false, pattern, offset, length });
+
+		}
+		void Prefetch(size_t offset, size_t length) override {
+
+			hints.push_back(Hint{ true, IO::AccessPattern::WillNeed, offset, length });
+
+		}
+	};
+
+	TEST_CLASS(FileStreamTests) {
+public:
+	// Tests that bytes written to a file can be read back, and that the length reflects the writes.
+	TEST_METHOD(ReadBackWrittenBytes) {
+
+		const char* path = "FileStreamTests.tmp";
+		IO::Byte input[] = { 1, 2, 3, 4, 5 };
+		IO::Byte output[sizeof(input)];
+
+		{
+			IO::FileStream fs(path, IO::FileMode::Create);
+			fs.Write(input, 0, sizeof(input));
+			Assert::AreEqual(sizeof(input), fs.Length());
+
+			fs.Seek(1);
+			Assert::AreEqual(sizeof(input) - 1, fs.Read(output, 0, sizeof(output)));
+			Assert::AreEqual((IO::Byte)2, output[0]);
+			Assert::AreEqual(sizeof(input), fs.Position());
+		}
+
+		{
+			IO::FileStream fs(path, IO::FileMode::Open, IO::FileAccess::Read);
+			Assert::AreEqual(sizeof(input), fs.Length());
+			Assert::AreEqual(sizeof(input), fs.Read(output, 0, sizeof(output)));
+			for (size_t i = 0; i < sizeof(input); ++i)
+				Assert::AreEqual(input[i], output[i]);
+		}
+
+		std::remove(path);
+
+	}
+	// Tests that SetLength truncates and extends the file in place, and that extended regions read as zeros.
+	TEST_METHOD(SetLengthTruncatesAndExtends) {
+
+		const char* path = "FileStreamTests.tmp";
+		IO::Byte input[] = { 1, 2, 3, 4, 5 };
+		IO::Byte output[8];
+
+		{
+			IO::FileStream fs(path, IO::FileMode::Create);
+			fs.Write(input, 0, sizeof(input));
+
+			fs.SetLength(2);
+			Assert::AreEqual((size_t)2, fs.Length());
+			Assert::AreEqual((size_t)2, fs.Position());
+
+			fs.SetLength(4);
+			fs.Seek(0);
+			Assert::AreEqual((size_t)4, fs.Read(output, 0, sizeof(output)));
+			Assert::AreEqual((IO::Byte)2, output[1]);
+			Assert::AreEqual((IO::Byte)0, output[3]);
+
+			fs.Preallocate(64);
+			Assert::AreEqual((size_t)64, fs.Length());
+		}
+
+		std::remove(path);
+
+	}
+#ifdef __linux__
+	// Tests that unaligned reads and writes on a direct I/O stream preserve the surrounding data.
+	TEST_METHOD(DirectUnalignedReadWrite) {
+
+		const char* path = "FileStreamTests.tmp";
+		std::vector<IO::Byte> input(10000);
+		std::vector<IO::Byte> output(10000);
+		for (size_t i = 0; i < input.size(); ++i)
+			input[i] = (IO::Byte)i;
+
+		{
+			IO::FileStream fs(path, IO::FileMode::Create, IO::FileAccess::ReadWrite, IO::FileOptions::Direct);
+			fs.Write(input.data(), 0, input.size());
+			Assert::AreEqual(input.size(), fs.Length());
+
+			// Overwrite a range straddling a block boundary.
+			IO::Byte patch[] = { 0xAA, 0xBB, 0xCC };
+			fs.Seek(4095);
+			fs.Write(patch, 0, sizeof(patch));
+			memcpy(&input[4095], patch, sizeof(patch));
+
+			fs.Seek(3);
+			Assert::AreEqual(input.size() - 3, fs.Read(output.data(), 0, output.size()));
+			Assert::IsTrue(memcmp(&input[3], output.data(), input.size() - 3) == 0);
+
+			// Positional I/O stages unaligned ranges through its own buffer.
+			fs.WriteAt(8190, patch, sizeof(patch));
+			memcpy(&input[8190], patch, sizeof(patch));
+			Assert::AreEqual((size_t)5, fs.ReadAt(8189, output.data(), 5));
+			Assert::IsTrue(memcmp(&input[8189], output.data(), 5) == 0);
+		}
+
+		// A read-only direct stream can read the file without asking for write access.
+		{
+			IO::FileStream fs(path, IO::FileMode::Open, IO::FileAccess::Read, IO::FileOptions::Direct);
+			Assert::AreEqual(input.size(), fs.Length());
+			Assert::IsTrue((fcntl(fs.Handle(), F_GETFL) & O_ACCMODE) == O_RDONLY);
+			Assert::AreEqual(input.size(), fs.Read(output.data(), 0, output.size()));
+			Assert::IsTrue(input == output);
+		}
+
+		std::remove(path);
+
+	}
+#endif
+	// Tests that a vectored write of several spans can be read back with a vectored read into differently sized spans.
+	TEST_METHOD(VectoredReadWrite) {
+
+		const char* path = "FileStreamTests.tmp";
+		IO::Byte header[] = { 1, 2, 3 };
+		IO::Byte body[] = { 4, 5, 6, 7, 8 };
+		IO::Byte first[4];
+		IO::Byte second[8];
+
+		{
+			IO::FileStream fs(path, IO::FileMode::Create);
+			IO::ConstSpan input[] = { { header, sizeof(header) }, { nullptr, 0 }, { body, sizeof(body) } };
+			fs.WriteV(input, 3);
+			Assert::AreEqual((size_t)8, fs.Length());
+			Assert::AreEqual((size_t)8, fs.Position());
+
+			fs.Seek(0);
+			IO::Span output[] = { { first, sizeof(first) }, { second, sizeof(second) } };
+			Assert::AreEqual((size_t)8, fs.ReadV(output, 2));
+			Assert::AreEqual((IO::Byte)4, first[3]);
+			Assert::AreEqual((IO::Byte)8, second[3]);
+		}
+
+		std::remove(path);
+
+	}
+	// Tests that positional reads and writes from several threads do not use or change the current position.
+	TEST_METHOD(PositionalReadWriteFromThreads) {
+
+		const char* path = "FileStreamTests.tmp";
+
+		{
+			IO::FileStream fs(path, IO::FileMode::Create);
+			fs.Write("ab", 0, 2);
+			Assert::IsTrue(fs.CanAccessConcurrently());
+
+			std::vector<std::thread> threads;
+			for (IO::Byte i = 0; i < 4; ++i)
+				threads.emplace_back([&fs, i] {
+					IO::Byte block[64];
+					memset(block, i, sizeof(block));
+					fs.WriteAt(64 * i, block, sizeof(block));
+				});
+			for (auto& thread : threads)
+				thread.join();
+
+			Assert::AreEqual((size_t)256, fs.Length());
+			Assert::AreEqual((size_t)2, fs.Position());
+
+			IO::Byte byte;
+			Assert::AreEqual((size_t)1, fs.ReadAt(200, &byte, 1));
+			Assert::AreEqual((IO::Byte)3, byte);
+			Assert::AreEqual((size_t)0, fs.ReadAt(256, &byte, 1));
+		}
+
+		std::remove(path);
+
+	}
+	// Tests that copying between file streams copies the remaining bytes and advances both positions.
+	TEST_METHOD(CopyToFileStream) {
+
+		const char* source_path = "FileStreamTests.tmp";
+		const char* destination_path = "FileStreamTests.copy.tmp";
+		std::vector<IO::Byte> input(100000);
+		for (size_t i = 0; i < input.size(); ++i)
+			input[i] = (IO::Byte)(i * 7);
+
+		{
+			IO::FileStream source(source_path, IO::FileMode::Create);
+			source.Write(input.data(), 0, input.size());
+			source.Seek(10);
+
+			IO::FileStream destination(destination_path, IO::FileMode::Create);
+			destination.Write("x", 0, 1);
+			source.CopyTo(static_cast<IO::IStream&>(destination));
+			Assert::AreEqual(input.size(), source.Position());
+			Assert::AreEqual(input.size() - 9, destination.Position());
+			Assert::AreEqual(input.size() - 9, destination.Length());
+
+			std::vector<IO::Byte> output(input.size() - 10);
+			Assert::AreEqual(output.size(), destination.ReadAt(1, output.data(), output.size()));
+			Assert::IsTrue(memcmp(input.data() + 10, output.data(), output.size()) == 0);
+		}
+
+		std::remove(source_path);
+		std::remove(destination_path);
+
+	}
+	// Tests that access hints given through a buffered stream or a bit reader reach the underlying stream, and do not disturb reads.
+	TEST_METHOD(AdviseThroughBufferedStream) {
+
+		const char* path = "FileStreamTests.tmp";
+
+		{
+			IO::FileStream fs(path, IO::FileMode::Create);
+			std::vector<IO::Byte> input(8192, 0x5a);
+			fs.Write(input.data(), 0, input.size());
+			fs.Seek(0);
+
+			IO::BufferedSteam bs(fs);
+			bs.Advise(IO::AccessPattern::Sequential, 0, 0);
+			bs.Prefetch(4096, 4096);
+			bs.Advise(IO::AccessPattern::DontNeed, 0, 4096);
+
+			IO::Byte output[16];
+			Assert::AreEqual(sizeof(output), bs.Read(output, 0, sizeof(output)));
+			Assert::AreEqual((IO::Byte)0x5a, output[15]);
+		}
+
+		std::remove(path);
+
+		// The hints arrive at the underlying stream unchanged, both through a buffered stream and through a bit reader's base stream.
+		HintRecordingStream recorder;
+		IO::BufferedSteam bs(recorder);
+		bs.Advise(IO::AccessPattern::Random, 128, 256);
+		bs.Prefetch(4096, 512);
+
+		IO::BitReader reader(bs);
+		reader.BaseStream().Advise(IO::AccessPattern::DontNeed, 0, 64);
+
+		Assert::AreEqual((size_t)3, recorder.hints.size());
+		Assert::IsFalse(recorder.hints[0].prefetch);
+		Assert::IsTrue(recorder.hints[0].pattern == IO::AccessPattern::Random);
+		Assert::AreEqual((size_t)128, recorder.hints[0].offset);
+		Assert::AreEqual((size_t)256, recorder.hints[0].length);
+		Assert::IsTrue(recorder.hints[1].prefetch);
+		Assert::AreEqual((size_t)4096, recorder.hints[1].offset);
+		Assert::AreEqual((size_t)512, recorder.hints[1].length);
+		Assert::IsFalse(recorder.hints[2].prefetch);
+		Assert::IsTrue(recorder.hints[2].pattern == IO::AccessPattern::DontNeed);
+		Assert::AreEqual((size_t)0, recorder.hints[2].offset);
+		Assert::AreEqual((size_t)64, recorder.hints[2].length);
+
+	}
+	// Tests that writers committing at the same time share syncs.
+	TEST_METHOD(GroupCommitBatchesSyncs) {
+
+		const char* path = "FileStreamTests.tmp";
+
+		{
+			IO::FileStream fs(path, IO::FileMode::Create);
+			fs.Sync(IO::SyncMode::Full);
+
+			// The writers share the stream without locking, which relies on positional writes being safe to make concurrently.
+			Assert::IsTrue(fs.CanAccessConcurrently());
+
+			IO::GroupCommit group(fs, IO::SyncMode::Data);
+			const size_t thread_count = 16;
+			const size_t commits_per_thread = 8;
+			std::atomic<bool> start(false);
+			std::vector<std::thread> threads;
+			for (size_t i = 0; i < thread_count; ++i)
+				threads.emplace_back([&, i] {
+					// Hold every thread at the gate, so that their commits overlap.
+					while (!start)
+						std::this_thread::yield();
+					for (size_t j = 0; j < commits_per_thread; ++j) {
+						IO::Byte record[8] = { (IO::Byte)i };
+						fs.WriteAt((i * commits_per_thread + j) * sizeof(record), record, sizeof(record));
+						group.Commit();
+					}
+				});
+			start = true;
+			for (auto& thread : threads)
+				thread.join();
+
+			// Commits that arrive while a sync is in progress are covered by a single later sync, so there must be fewer syncs than commits.
+			Assert::AreEqual((size_t)1024, fs.Length());
+			Assert::IsTrue(group.SyncCount() >= 1);
+			Assert::IsTrue(group.SyncCount() < thread_count * commits_per_thread);
+
+			// Every record landed at its own offset.
+			for (size_t i = 0; i < thread_count * commits_per_thread; ++i) {
+				IO::Byte record[8];
+				Assert::AreEqual(sizeof(record), fs.ReadAt(i * sizeof(record), record, sizeof(record)));
+				Assert::AreEqual((IO::Byte)(i / commits_per_thread), record[0]);
+			}
+		}
+
+		std::remove(path);
+
+	}
+	// Tests that a sparse copy reproduces the contents and length of a file with holes, and that punched holes read as zeros.
+	TEST_METHOD(SparseCopyAndPunchHole) {
+
+		const char* source_path = "FileStreamTests.tmp";
+		const char* destination_path = "FileStreamTests.copy.tmp";
+		const size_t length = 3 * 1024 * 1024;
+
+		{
+			IO::FileStream source(source_path, IO::FileMode::Create);
+			source.Write("head", 0, 4);
+			source.WriteAt(1024 * 1024, "body", 4);
+			source.SetLength(length);
+
+			Assert::AreEqual((size_t)0, source.SeekData(0));
+			size_t hole = source.SeekHole(0);
+			Assert::IsTrue(hole >= 4 && hole <= length);
+
+			// Overwrite an existing file, so that its old contents have to be replaced by holes.
+			IO::FileStream destination(destination_path, IO::FileMode::Create);
+			std::vector<IO::Byte> garbage(2 * 1024 * 1024, 0xff);
+			destination.Write(garbage.data(), 0, garbage.size());
+			destination.Seek(0);
+
+			source.Seek(0);
+			source.CopyTo(destination, IO::CopyMode::PreserveHoles);
+			Assert::AreEqual(length, source.Position());
+			Assert::AreEqual(length, destination.Length());
+
+			IO::Byte output[4];
+			destination.ReadAt(1024 * 1024, output, sizeof(output));
+			Assert::IsTrue(memcmp(output, "body", 4) == 0);
+			destination.ReadAt(1024 * 1024 + 4096, output, sizeof(output));
+			Assert::AreEqual((IO::Byte)0, output[0]);
+
+			destination.PunchHole(0, 4096);
+			destination.ReadAt(0, output, sizeof(output));
+			Assert::AreEqual((IO::Byte)0, output[3]);
+			Assert::AreEqual(length, destination.Length());
+		}
+
+		std::remove(source_path);
+		std::remove(destination_path);
+
+	}
+	// Tests that streams opened through a handle cache share a descriptor, and that unused descriptors are evicted beyond the cache's capacity.
+	TEST_METHOD(HandleCacheSharesDescriptors) {
+
+		const char* path = "FileStreamTests.tmp";
+		const char* other_path = "FileStreamTests.other.tmp";
+		IO::FileHandleCache cache(1);
+
+		{
+			IO::FileStream first(path, IO::FileMode::Create, IO::FileAccess::ReadWrite, cache);
+			first.Write("abc", 0, 3);
+
+			IO::FileStream second(path, IO::FileMode::Open, IO::FileAccess::ReadWrite, cache);
+			Assert::AreEqual(first.Handle(), second.Handle());
+			Assert::AreEqual((size_t)3, second.Length());
+			Assert::AreEqual((size_t)0, second.Position());
+		}
+
+		// The descriptor stays open after both streams have closed, until another file displaces it.
+		Assert::AreEqual((size_t)1, cache.Count());
+		{
+			IO::FileStream first(path, IO::FileMode::Open, IO::FileAccess::Read, cache);
+			IO::FileStream other(other_path, IO::FileMode::Create, IO::FileAccess::Write, cache);
+			Assert::AreEqual((size_t)2, cache.Count());
+		}
+		Assert::AreEqual((size_t)1, cache.Count());
+
+		cache.Invalidate(path);
+		Assert::AreEqual((size_t)0, cache.Count());
+
+		std::remove(path);
+		std::remove(other_path);
+
+	}
+	// Tests that opening a file that does not exist with FileMode::Open throws.
+	TEST_METHOD(OpenMissingFileThrows) {
+
+		Assert::ExpectException<IO::FileNotFoundException>([] {
+			IO::FileStream fs("FileStreamTests.missing", IO::FileMode::Open);
+		});
+
+	}
+	};
+
+	TEST_CLASS(AppendStreamTests) {
+public:
+	// Tests that records appended from several threads are written whole, without overlapping, after the existing contents of the file.
+	TEST_METHOD(ConcurrentAppendsDoNotInterleave) {
+
+		const char* path = "AppendStreamTests.tmp";
+
+		{
+			IO::FileStream fs(path, IO::FileMode::Create);
+			fs.Write("log:", 0, 4);
+		}
+
+		{
+			IO::AppendStream as(path);
+			std::vector<std::thread> threads;
+			for (IO::Byte i = 0; i < 8; ++i)
+				threads.emplace_back([&as, i] {
+					IO::Byte record[100];
+					memset(record, 'a' + i, sizeof(record));
+					for (size_t j = 0; j < 50; ++j) {
+						IO::ConstSpan spans[] = { { record, 40 }, { record + 40, 60 } };
+						Assert::IsTrue(as.Append(spans, 2) >= 4);
+					}
+				});
+			for (auto& thread : threads)
+				thread.join();
+
+			as.Flush();
+			Assert::AreEqual((size_t)(4 + 8 * 50 * 100), as.Watermark());
+		}
+
+		{
+			IO::FileStream fs(path, IO::FileMode::Open, IO::FileAccess::Read);
+			Assert::AreEqual((size_t)(4 + 8 * 50 * 100), fs.Length());
+
+			std::vector<IO::Byte> record(100);
+			fs.Seek(4);
+			while (fs.Read(record.data(), 0, record.size()) == record.size())
+				for (size_t i = 1; i < record.size(); ++i)
+					Assert::AreEqual(record[0], record[i]);
+		}
+
+		std::remove(path);
+
+	}
+	};
+
+#ifdef __linux__
+	TEST_CLASS(AsyncFileStreamTests) {
+public:
+	// Tests that a batch of writes at explicit positions can be read back with a batch of reads into registered buffers.
+	TEST_METHOD(BatchedWritesCanBeReadBack) {
+
+		const char* path = "AsyncFileStreamTests.tmp";
+		IO::Byte input[4][16];
+		IO::Byte output[4][16];
+
+		{
+			IO::AsyncFileStream fs(path, IO::FileMode::Create);
+
+			// Write the blocks in reverse order, each at its own position.
+			for (int i = 3; i >= 0; --i) {
+				memset(input[i], i + 1, sizeof(input[i]));
+				Assert::IsTrue(fs.QueueWrite(input[i], sizeof(input[i]), i * sizeof(input[i]), i));
+			}
+
+			IO::AsyncCompletion completions[4];
+			Assert::AreEqual((size_t)4, fs.WaitCompletions(completions, 4, 4));
+			for (int i = 0; i < 4; ++i)
+				Assert::AreEqual((long long)sizeof(input[i]), completions[i].result);
+			Assert::AreEqual(sizeof(input), fs.Length());
+
+			// Read them back into registered buffers.
+			IO::AsyncBuffer buffers[] = { { output, sizeof(output) } };
+			fs.RegisterBuffers(buffers, 1);
+			for (int i = 0; i < 4; ++i)
+				Assert::IsTrue(fs.QueueReadFixed(0, i * sizeof(output[i]), sizeof(output[i]), i * sizeof(output[i]), i));
+			Assert::AreEqual((size_t)4, fs.Submit());
+			Assert::AreEqual((size_t)4, fs.WaitCompletions(completions, 4, 4));
+
+			// Requests too long for the kernel's 32-bit length field are rejected rather than truncated.
+			Assert::ExpectException<ArgumentException>([&] { fs.QueueRead(output, (size_t)1 << 32, 0, 0); });
+		}
+
+		Assert::IsTrue(memcmp(input, output, sizeof(input)) == 0);
+
+		std::remove(path);
+
+	}
+	};
+#endif
+
+#ifndef _WIN32
+	TEST_CLASS(MappedFileStreamTests) {
+public:
+	// Tests that a mapped file grows as it is written to, and is trimmed to its length when closed.
+	TEST_METHOD(WriteGrowsAndCloseTrimsFile) {
+
+		const char* path = "MappedFileStreamTests.tmp";
+
+		{
+			IO::MappedFileStream ms(path, IO::FileMode::Create);
+			for (int i = 0; i < 10000; ++i)
+				ms.WriteByte((IO::Byte)i);
+			Assert::AreEqual((size_t)10000, ms.Length());
+			Assert::AreEqual((IO::Byte)123, ms.Data()[123]);
+		}
+
+		{
+			IO::FileStream fs(path, IO::FileMode::Open, IO::FileAccess::Read);
+			Assert::AreEqual((size_t)10000, fs.Length());
+		}
+
+		std::remove(path);
+
+	}
+	// Tests that a BitReader can decode the mapped contents of a file in place.
+	TEST_METHOD(BitReaderDecodesMappedData) {
+
+		const char* path = "MappedFileStreamTests.tmp";
+
+		{
+			IO::FileStream fs(path, IO::FileMode::Create);
+			IO::BitWriter bw(fs);
+			bw.WriteInteger(65);
+			bw.Flush();
+		}
+
+		{
+			IO::MappedFileStream ms(path, IO::FileMode::Open, IO::FileAccess::Read);
+			IO::MemoryStream view(ms.Data(), (size_t)ms.Length());
+			IO::BitReader br(view);
+
+			signed int value = 0;
+			br.ReadInteger(value);
+			Assert::AreEqual(65, value);
+		}
+
+		std::remove(path);
+
+	}
+	};
+#endif
+
+#ifndef _WIN32
+	TEST_CLASS(SharedMemoryStreamTests) {
+public:
+	// Tests that a stream created under a name can be opened by name, and that writes through one are seen by the other along with the new length and generation.
+	TEST_METHOD(OpenByNameAndWaitForWrites) {
+
+		IO::SharedMemoryStream::Remove("streams-test-shm");
+		IO::SharedMemoryStream writer("streams-test-shm", 4096);
+		IO::SharedMemoryStream reader("streams-test-shm");
+		Assert::AreEqual((size_t)4096, reader.Capacity());
+
+		uint32_t generation = reader.Generation();
+		Assert::IsFalse(reader.WaitForChange(generation, 0));
+
+		std::thread thread([&writer] {
+			writer.Write("hello", 0, 5);
+		});
+		Assert::IsTrue(reader.WaitForChange(generation, 5000));
+		thread.join();
+
+		char output[6] = {};
+		Assert::AreEqual((size_t)5, reader.Length());
+		Assert::AreEqual((size_t)5, reader.Read(output, 0, 5));
+		Assert::AreEqual(std::string("hello"), std::string(output));
+
+		// Writes beyond the capacity are rejected.
+		writer.Seek(4090);
+		Assert::ExpectException<IO::IOException>([&writer] { writer.Write("0123456789", 0, 10); });
+
+	}
+	// Tests that opening an object that its creator never finished initializing gives up with an exception instead of reading an empty header.
+	TEST_METHOD(OpenUninitializedThrows) {
+
+		IO::SharedMemoryStream::Remove("streams-test-shm-raw");
+		int fd = shm_open("/streams-test-shm-raw", O_RDWR | O_CREAT | O_EXCL, 0600);
+		Assert::IsTrue(fd >= 0);
+		Assert::AreEqual(0, ftruncate(fd, 4096));
+
+		Assert::ExpectException<IO::IOException>([] { IO::SharedMemoryStream reader("streams-test-shm-raw"); });
+
+		close(fd);
+		IO::SharedMemoryStream::Remove("streams-test-shm-raw");
+
+	}
+	// Tests that a channel carries more data than its ring holds from one side to the other, in order.
+	TEST_METHOD(ChannelTransfersThroughRing) {
+
+		IO::SharedMemoryStream::Remove("streams-test-channel");
+		IO::SharedMemoryChannel sender("streams-test-channel", 4096);
+		IO::SharedMemoryChannel receiver("streams-test-channel");
+		Assert::AreEqual((size_t)4096, receiver.Capacity());
+
+		std::vector<IO::Byte> payload(1024 * 1024);
+		for (size_t i = 0; i < payload.size(); ++i)
+			payload[i] = (IO::Byte)(i * 7);
+
+		std::thread thread([&] {
+			sender.Send(payload.data(), payload.size());
+		});
+
+		std::vector<IO::Byte> output;
+		IO::Byte chunk[3000];
+		while (output.size() < payload.size()) {
+			size_t count = receiver.Receive(chunk, sizeof(chunk), 5000);
+			Assert::IsTrue(count > 0);
+			output.insert(output.end(), chunk, chunk + count);
+		}
+		thread.join();
+
+		Assert::IsTrue(output == payload);
+		Assert::AreEqual((size_t)0, receiver.Receive(chunk, sizeof(chunk), 0));
+
+	}
+	// Tests that a send's timeout covers the whole call even while a slow receiver keeps making room, and that a channel without room is rejected.
+	TEST_METHOD(ChannelSendTimeoutCoversWholeCall) {
+
+		Assert::ExpectException<IO::IOException>([] { IO::SharedMemoryChannel channel("streams-test-channel-empty", 0); });
+
+		IO::SharedMemoryStream::Remove("streams-test-channel");
+		IO::SharedMemoryChannel sender("streams-test-channel", 4096);
+		IO::SharedMemoryChannel receiver("streams-test-channel");
+
+		std::atomic<bool> done(false);
+		std::thread thread([&] {
+			IO::Byte chunk[1024];
+			while (!done) {
+				receiver.Receive(chunk, sizeof(chunk), 10);
+				std::this_thread::sleep_for(std::chrono::milliseconds(10));
+			}
+		});
+
+		std::vector<IO::Byte> payload(1024 * 1024);
+		auto start = std::chrono::steady_clock::now();
+		size_t sent = sender.Send(payload.data(), payload.size(), 100);
+		auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+
+		done = true;
+		thread.join();
+
+		Assert::IsTrue(sent < payload.size());
+		Assert::IsTrue(elapsed < 2000);
+
+	}
+	};
+#endif
+
+	TEST_CLASS(MemoryStreamTests) {
+public:
+	// Tests that a vectored write appends every span in order.
+	TEST_METHOD(WriteVAppendsSpans) {
+
+		IO::MemoryStream ms;
+		IO::Byte header[] = { 1, 2 };
+		IO::Byte body[] = { 3, 4, 5 };
+		IO::ConstSpan spans[] = { { header, sizeof(header) }, { body, sizeof(body) } };
+
+		ms.WriteV(spans, 2);
+		Assert::AreEqual((size_t)5, ms.Length());
+
+		ms.Seek(0);
+		IO::Byte output[5];
+		Assert::AreEqual((size_t)5, ms.Read(output, 0, sizeof(output)));
+		Assert::AreEqual((IO::Byte)3, output[2]);
+
+	}
+	// Tests that a positional write past the end extends the stream, and that the current position is left unchanged.
+	TEST_METHOD(WriteAtExtendsWithoutMovingPosition) {
+
+		IO::MemoryStream ms;
+		IO::Byte input[] = { 1, 2, 3 };
+		IO::Byte output[4];
+
+		ms.WriteAt(4, input, sizeof(input));
+		Assert::AreEqual((size_t)7, ms.Length());
+		Assert::AreEqual((size_t)0, ms.Position());
+
+		Assert::AreEqual((size_t)2, ms.ReadAt(5, output, sizeof(output)));
+		Assert::AreEqual((IO::Byte)3, output[1]);
+
+	}
+	// Tests that a detached buffer holds the stream's contents, and that the stream is left empty and usable.
+	TEST_METHOD(DetachTransfersBuffer) {
+
+		IO::MemoryStream ms;
+		ms.Write("hello", 0, 5);
+		Assert::AreEqual((size_t)5, ms.GetSpan().length);
+
+		size_t length;
+		size_t capacity;
+		IO::Byte* buffer = ms.Detach(length, capacity);
+		Assert::AreEqual((size_t)5, length);
+		Assert::IsTrue(capacity >= length);
+		Assert::IsTrue(memcmp(buffer, "hello", 5) == 0);
+		Assert::AreEqual((size_t)0, ms.Length());
+
+		// Hand the buffer to a new stream, which takes over freeing it and can grow it.
+		IO::MemoryStream adopted(buffer, length, capacity, true);
+		adopted.Seek(0, IO::SeekOrigin::End);
+		adopted.Write(" world", 0, 6);
+
+		IO::Span span;
+		Assert::IsTrue(adopted.TryGetBuffer(span));
+		Assert::AreEqual((size_t)11, span.length);
+		Assert::IsTrue(memcmp(span.data, "hello world", 11) == 0);
+
+	}
+	// Tests that bytes skipped by seeking past the end, or added by extending the stream, read as zeros even though growth does not clear memory.
+	TEST_METHOD(GapsReadAsZeros) {
+
+		IO::MemoryStream ms;
+		IO::Byte input[8];
+		memset(input, 0xff, sizeof(input));
+
+		ms.Write(input, 0, sizeof(input));
+		ms.SetLength(2);
+		ms.SetLength(6);
+		ms.Seek(100);
+		ms.WriteByte(1);
+
+		IO::Byte output[101];
+		ms.Seek(0);
+		Assert::AreEqual((size_t)101, ms.Read(output, 0, sizeof(output)));
+		Assert::AreEqual((IO::Byte)0xff, output[1]);
+		Assert::AreEqual((IO::Byte)0, output[2]);
+		Assert::AreEqual((IO::Byte)0, output[7]);
+		Assert::AreEqual((IO::Byte)0, output[99]);
+		Assert::AreEqual((IO::Byte)1, output[100]);
+
+	}
+	// Tests that an expandable stream grows to a minimum capacity on its first write, rather than a byte at a time.
+	TEST_METHOD(GrowthStartsAtMinimumCapacity) {
+
+		IO::MemoryStream ms;
+		ms.WriteByte(1);
+		Assert::AreEqual((size_t)64, ms.Capacity());
+
+		for (int i = 0; i < 63; ++i)
+			ms.WriteByte(1);
+		Assert::AreEqual((size_t)64, ms.Capacity());
+
+	}
+	// Tests that truncating a heap-backed stream keeps its capacity, so that it can be refilled without reallocating.
+	TEST_METHOD(TruncateKeepsCapacity) {
+
+		IO::MemoryStream ms(64 * 1024);
+		ms.SetLength(64 * 1024);
+		ms.SetLength(0);
+		Assert::AreEqual((size_t)64 * 1024, ms.Capacity());
+
+	}
+	// Tests that a SmallMemoryStream keeps small contents inside the object, and spills them to the heap intact once they outgrow it.
+	TEST_METHOD(SmallMemoryStreamSpillsToHeap) {
+
+		IO::SmallMemoryStream<32> ms;
+		const IO::Byte* begin = (const IO::Byte*)&ms;
+		const IO::Byte* end = begin + sizeof(ms);
+
+		ms.Write("0123456789abcdef", 0, 16);
+		Assert::AreEqual((size_t)32, ms.Capacity());
+		Assert::IsTrue(ms.GetSpan().data >= begin && ms.GetSpan().data < end);
+
+		ms.Write("0123456789abcdef0123456789abcdef", 0, 32);
+		Assert::IsTrue(ms.Capacity() >= 48);
+		Assert::IsFalse(ms.GetSpan().data >= begin && ms.GetSpan().data < end);
+		Assert::IsTrue(memcmp(ms.GetSpan().data, "0123456789abcdef0123456789abcdef0123456789abcdef", 48) == 0);
+
+		// Detaching hands out a heap copy, and the stream goes back to its inline storage.
+		size_t length;
+		size_t capacity;
+		IO::Byte* buffer = ms.Detach(length, capacity);
+		Assert::AreEqual((size_t)48, length);
+		Assert::IsTrue(capacity >= length);
+		free(buffer);
+		ms.Write("xy", 0, 2);
+		Assert::AreEqual((size_t)32, ms.Capacity());
+		Assert::IsTrue(ms.GetSpan().data >= begin && ms.GetSpan().data < end);
+
+	}
+	// Tests that copies of a MemoryStreamView share one block with independent positions, and that writing to one copies the block.
+	TEST_METHOD(MemoryStreamViewCopiesOnWrite) {
+
+		IO::MemoryStreamView view("hello world", 11);
+		IO::MemoryStreamView copy(view);
+		Assert::IsTrue(view.IsShared());
+		Assert::IsTrue(view.GetSpan().data == copy.GetSpan().data);
+
+		char output[6] = {};
+		copy.Seek(6);
+		Assert::AreEqual((size_t)5, copy.Read(output, 0, 5));
+		Assert::AreEqual(std::string("world"), std::string(output));
+		Assert::AreEqual((size_t)0, view.Position());
+
+		// Writing gives the writer a private block, and leaves the other view's contents alone.
+		view.Write("HELLO", 0, 5);
+		Assert::IsFalse(view.IsShared());
+		Assert::IsFalse(copy.IsShared());
+		Assert::IsTrue(memcmp(view.GetSpan().data, "HELLO world", 11) == 0);
+		Assert::IsTrue(memcmp(copy.GetSpan().data, "hello world", 11) == 0);
+
+	}
+	// Tests that a closed memory stream exposes an empty span, and that a view of it is empty.
+	TEST_METHOD(ClosedStreamHasEmptySpan) {
+
+		IO::MemoryStream ms;
+		ms.Write("hello", 0, 5);
+		ms.Close();
+		Assert::IsTrue(ms.GetSpan().data == nullptr);
+		Assert::AreEqual((size_t)0, ms.GetSpan().length);
+
+		IO::MemoryStreamView view(ms);
+		Assert::AreEqual((size_t)0, view.Length());
+
+	}
+	// Tests that views of the same block can be read from several threads at once.
+	TEST_METHOD(MemoryStreamViewConcurrentReaders) {
+
+		std::vector<IO::Byte> payload(4096);
+		for (size_t i = 0; i < payload.size(); ++i)
+			payload[i] = (IO::Byte)i;
+
+		IO::MemoryStreamView view(payload.data(), payload.size());
+		std::vector<int> matches(4);
+		std::vector<std::thread> threads;
+		for (size_t t = 0; t < matches.size(); ++t) {
+			threads.emplace_back([&, t, reader = IO::MemoryStreamView(view)]() mutable {
+				std::vector<IO::Byte> output(payload.size());
+				for (int pass = 0; pass < 50; ++pass) {
+					reader.Seek(0);
+					reader.Read(output.data(), 0, output.size());
+					matches[t] += output == payload;
+				}
+			});
+		}
+		for (std::thread& thread : threads)
+			thread.join();
+
+		for (int count : matches)
+			Assert::AreEqual(50, count);
+
+	}
+	};
+
+	TEST_CLASS(SegmentedMemoryStreamTests) {
+public:
+	// Tests that writes spanning several segments can be read back, and that the segments can be iterated as spans.
+	TEST_METHOD(WritesSpanSegments) {
+
+		IO::SegmentedMemoryStream ms(16);
+		IO::Byte input[40];
+		for (size_t i = 0; i < sizeof(input); ++i)
+			input[i] = (IO::Byte)i;
+
+		ms.Write(input, 0, sizeof(input));
+		Assert::AreEqual((size_t)40, ms.Length());
+		Assert::AreEqual((size_t)3, ms.SegmentCount());
+		Assert::AreEqual((size_t)8, ms.Segment(2).length);
+
+		IO::ConstSpan span = ms.GetSpan(10);
+		Assert::AreEqual((size_t)6, span.length);
+		Assert::AreEqual((IO::Byte)10, span.data[0]);
+
+		IO::Byte output[40];
+		ms.Seek(0);
+		Assert::AreEqual((size_t)40, ms.Read(output, 0, sizeof(output)));
+		Assert::IsTrue(memcmp(input, output, sizeof(input)) == 0);
+
+	}
+	// Tests that seeking past the end and writing leaves a gap that reads as zeros, even after the stream has been shortened.
+	TEST_METHOD(GapsReadAsZeros) {
+
+		IO::SegmentedMemoryStream ms(16);
+		IO::Byte input[20];
+		memset(input, 0xff, sizeof(input));
+
+		ms.Write(input, 0, sizeof(input));
+		ms.SetLength(4);
+		ms.Seek(30);
+		ms.WriteByte(1);
+
+		IO::Byte output[31];
+		ms.Seek(0);
+		Assert::AreEqual((size_t)31, ms.Read(output, 0, sizeof(output)));
+		Assert::AreEqual((IO::Byte)0xff, output[3]);
+		Assert::AreEqual((IO::Byte)0, output[4]);
+		Assert::AreEqual((IO::Byte)0, output[19]);
+		Assert::AreEqual((IO::Byte)1, output[30]);
+
+	}
+	};
+
+	TEST_CLASS(SpillStreamTests) {
+public:
+	// Tests that a SpillStream moves to a temporary file once it exceeds its threshold, keeping its contents and position.
+	TEST_METHOD(SpillsPastThreshold) {
+
+		IO::SpillStream stream(16, ".");
+		stream.Write("0123456789", 0, 10);
+		Assert::IsFalse(stream.IsSpilled());
+
+		stream.Seek(4);
+		stream.Write("abcdefghijklmnop", 0, 16);
+		Assert::IsTrue(stream.IsSpilled());
+		Assert::AreEqual((size_t)20, stream.Position());
+		Assert::AreEqual((size_t)20, stream.Length());
+
+		char output[21] = {};
+		stream.Seek(0);
+		Assert::AreEqual((size_t)20, stream.Read(output, 0, 20));
+		Assert::AreEqual(std::string("0123abcdefghijklmnop"), std::string(output));
+
+		// The stream keeps working as a file, including truncation.
+		stream.SetLength(6);
+		Assert::AreEqual((size_t)6, stream.Length());
+		Assert::AreEqual((size_t)6, stream.Position());
+
+	}
+	// Tests that byte-at-a-time access to a spilled stream is buffered, and stays consistent with positional access and copies.
+	TEST_METHOD(SpilledStreamMixesBufferedAndPositionalAccess) {
+
+		IO::SpillStream stream(16, ".");
+		for (int i = 0; i < 10000; ++i)
+			stream.WriteByte((IO::Byte)i);
+		Assert::IsTrue(stream.IsSpilled());
+		Assert::AreEqual((size_t)10000, stream.Position());
+
+		// Positional access sees the buffered bytes, and the buffer sees positional writes.
+		IO::Byte byte = 0;
+		Assert::AreEqual((size_t)1, stream.ReadAt(9999, &byte, 1));
+		Assert::AreEqual((IO::Byte)(9999 & 0xff), byte);
+		stream.WriteAt(5000, "x", 1);
+
+		stream.Seek(4999);
+		Assert::IsTrue(stream.ReadByte(byte));
+		Assert::AreEqual((IO::Byte)(4999 & 0xff), byte);
+		Assert::IsTrue(stream.ReadByte(byte));
+		Assert::AreEqual((IO::Byte)'x', byte);
+
+		stream.Seek(9998);
+		stream.WriteByte(7);
+		IO::MemoryStream copy;
+		stream.Seek(0);
+		stream.CopyTo(copy);
+		Assert::AreEqual((size_t)10000, copy.Length());
+		Assert::AreEqual((IO::Byte)'x', copy.GetSpan().data[5000]);
+		Assert::AreEqual((IO::Byte)7, copy.GetSpan().data[9998]);
+
+	}
+	};
+
 	TEST_CLASS(BitWriterTests) {
 public:
 	// Tests multidirectional bit-level seeking and writing in a stream containing multiple bytes.